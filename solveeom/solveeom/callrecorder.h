@@ -0,0 +1,193 @@
+﻿/*! \file callrecorder.h
+    \brief C APIの呼び出しをバイナリ形式で記録するクラスの宣言と実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _CALLRECORDER_H_
+#define _CALLRECORDER_H_
+
+#pragma once
+
+#include <array>            // for std::array
+#include <cstdint>          // for std::int32_t, std::uint8_t, std::uint32_t
+#include <fstream>          // for std::ofstream
+#include <string>           // for std::string
+#include <type_traits>      // for std::is_same_v, std::is_trivially_copyable_v
+
+namespace solveeom {
+    //!  A enumerated type
+    /*!
+        記録されるC APIの関数を表す列挙型
+        各レコードは、この値（1バイト）、引数、戻り値の順にリトルエンディアンの生のバイト列で書かれる
+        （boolは1バイト、floatとstd::int32_tは4バイト、doubleは8バイト、配列は要素を順に並べたもの）
+        記録ファイルは必ずINITのレコードから始まる
+    */
+    enum class Call_type : std::uint8_t {
+        // init(float l, float r, bool resistance, bool simpleharmonic, float theta0)
+        INIT = 0,
+        // nextstep(float dt) -> float
+        NEXTSTEP = 1,
+        // gettheta() -> float
+        GETTHETA = 2,
+        // getv() -> float
+        GETV = 3,
+        // kinetic_energy() -> float
+        KINETICENERGY = 4,
+        // potential_energy() -> float
+        POTENTIALENERGY = 5,
+        // setfluid(std::int32_t fluid)
+        SETFLUID = 6,
+        // setresistance(bool resistance)
+        SETRESISTANCE = 7,
+        // setsimpleharmonic(bool simpleharmonic)
+        SETSIMPLEHARMONIC = 8,
+        // settheta(float theta)
+        SETTHETA = 9,
+        // setv(float v)
+        SETV = 10,
+        // setdrive(double amplitude, double frequency, double phase)
+        SETDRIVE = 11,
+        // setsnapshot(double const state[13])
+        // 記録の開始時と、saveresult・saveresult_decimated・fitparametersの後にも、状態を揃えるために記録される
+        SETSNAPSHOT = 12
+    };
+
+    //! A global variable (constant expression).
+    /*!
+        記録ファイルの先頭に書かれるマジックナンバー
+    */
+    static std::array<char, 8> constexpr CALLRECORDMAGIC = { 'S', 'E', 'O', 'M', 'R', 'E', 'C', '1' };
+
+    //! A class.
+    /*!
+        C APIの呼び出しとその引数・戻り値を、コンパクトなバイナリ形式でファイルに記録するクラス
+    */
+    class CallRecorder final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param filename 記録ファイル名
+        */
+        explicit CallRecorder(std::string const & filename);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~CallRecorder() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function (template function).
+        /*!
+            一回の呼び出しを記録する
+            \param type 呼び出された関数
+            \param values 引数と戻り値
+        */
+        template <typename... Ts>
+        void operator()(Call_type type, Ts... values);
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function (template function).
+        /*!
+            値を生のバイト列で書き込む
+            \param value 書き込む値
+        */
+        template <typename T>
+        void write(T value);
+
+        // #endregion privateメンバ関数
+
+        // #region メンバ変数
+
+        //! A private static member variable (constant expression).
+        /*!
+            書き込みバッファの大きさ
+        */
+        static auto constexpr BUFSIZE = 1 << 16;
+
+        //! A private member variable.
+        /*!
+            書き込みバッファ
+        */
+        std::array<char, CallRecorder::BUFSIZE> buf_;
+
+        //! A private member variable.
+        /*!
+            記録ファイルのストリーム
+        */
+        std::ofstream ofs_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        CallRecorder() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        CallRecorder(CallRecorder const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        CallRecorder & operator=(CallRecorder const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+
+    // #region コンストラクタの実装
+
+    inline CallRecorder::CallRecorder(std::string const & filename)
+    {
+        ofs_.rdbuf()->pubsetbuf(buf_.data(), buf_.size());
+        ofs_.open(filename, std::ios::binary | std::ios::trunc);
+        ofs_.write(CALLRECORDMAGIC.data(), CALLRECORDMAGIC.size());
+    }
+
+    // #endregion コンストラクタの実装
+
+    // #region template関数の実装
+
+    template <typename... Ts>
+    inline void CallRecorder::operator()(Call_type type, Ts... values)
+    {
+        write(static_cast<std::uint8_t>(type));
+        (write(values), ...);
+    }
+
+    template <typename T>
+    inline void CallRecorder::write(T value)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            write(static_cast<std::uint8_t>(value ? 1 : 0));
+        }
+        else {
+            static_assert(std::is_trivially_copyable_v<T>, "生のバイト列で書き込める型のみ記録できる");
+            ofs_.write(reinterpret_cast<char const *>(&value), sizeof(T));
+        }
+    }
+
+    // #endregion template関数の実装
+}
+
+#endif  // _CALLRECORDER_H_
@@ -0,0 +1,138 @@
+﻿/*! \file observables.cpp
+    \brief 保存された軌跡から物理量をまとめて求めるクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "observables.h"
+#include <algorithm>                            // for std::copy, std::min
+#include <array>                                // for std::array
+#include <cmath>                                // for std::cos, std::fabs
+#include <boost/math/constants/constants.hpp>   // for boost::math::constants::pi
+
+namespace solveeom {
+    // #region コンストラクタ・デストラクタ
+
+    Observables::Observables(SolveEoM const & se) :
+        l_(se.l_),
+        m_(se.m_),
+        myu_(se.myu_),
+        nyu_(se.nyu_),
+        r_(se.r_),
+        rho_(se.rho_)
+    {
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    void Observables::operator()(double const * theta, double const * omega, std::size_t n, std::int32_t observables, double * result) const
+    {
+        auto const has = [observables](Observable_type type)
+        {
+            return (observables & static_cast<std::int32_t>(type)) != 0;
+        };
+
+        // 出力先の配列の先頭
+        auto out = result;
+        auto const next = [&out, n](bool enabled)
+        {
+            if (!enabled) {
+                return static_cast<double *>(nullptr);
+            }
+
+            auto const p = out;
+            out += n;
+            return p;
+        };
+
+        auto const kinetic = next(has(Observable_type::KINETICENERGY));
+        auto const potential = next(has(Observable_type::POTENTIALENERGY));
+        auto const total = next(has(Observable_type::TOTALENERGY));
+        auto const reynolds = next(has(Observable_type::REYNOLDS));
+        auto const stokes = next(has(Observable_type::STOKESFORCE));
+        auto const dragcoefficient = next(has(Observable_type::DRAGCOEFFICIENT));
+        auto const power = next(has(Observable_type::DISSIPATEDPOWER));
+
+        auto const needenergy = kinetic || potential || total;
+        auto const needdrag = reynolds || dragcoefficient || power;
+
+        auto const pi = boost::math::constants::pi<double>();
+        auto const halfm = 0.5 * m_;
+        auto const mgl = m_ * SolveEoM::g * l_;
+        auto const stokescoeff = 6.0 * pi * myu_ * r_;
+        auto const recoeff = 2.0 * r_ / nyu_;
+        auto const inertialcoeff = 0.5 * rho_ * pi * r_ * r_;
+
+        // ブロック内で共通に用いる中間量
+        std::array<double, Observables::BLOCK> v, ek, ep, re, cd;
+
+        for (std::size_t begin = 0; begin < n; begin += Observables::BLOCK) {
+            auto const size = std::min(static_cast<std::size_t>(Observables::BLOCK), n - begin);
+            auto const th = theta + begin;
+            auto const om = omega + begin;
+
+            for (std::size_t i = 0; i < size; i++) {
+                v[i] = l_ * om[i];
+            }
+
+            if (needenergy) {
+                for (std::size_t i = 0; i < size; i++) {
+                    ek[i] = halfm * v[i] * v[i];
+                    ep[i] = mgl * (1.0 - std::cos(th[i]));
+                }
+
+                if (kinetic) {
+                    std::copy(ek.begin(), ek.begin() + size, kinetic + begin);
+                }
+
+                if (potential) {
+                    std::copy(ep.begin(), ep.begin() + size, potential + begin);
+                }
+
+                if (total) {
+                    for (std::size_t i = 0; i < size; i++) {
+                        total[begin + i] = ek[i] + ep[i];
+                    }
+                }
+            }
+
+            if (stokes) {
+                for (std::size_t i = 0; i < size; i++) {
+                    stokes[begin + i] = stokescoeff * v[i];
+                }
+            }
+
+            if (needdrag) {
+                for (std::size_t i = 0; i < size; i++) {
+                    re[i] = recoeff * std::fabs(v[i]);
+                }
+
+                if (reynolds) {
+                    std::copy(re.begin(), re.begin() + size, reynolds + begin);
+                }
+
+                if (dragcoefficient || power) {
+                    // 運動方程式と同じく、レイノルズ数が閾値未満では粘性抵抗のみとする
+                    for (std::size_t i = 0; i < size; i++) {
+                        cd[i] = re[i] < SolveEoM::THRESHOLD ? 0.0 : SolveEoM::drag_coefficient(re[i]);
+                    }
+
+                    if (dragcoefficient) {
+                        std::copy(cd.begin(), cd.begin() + size, dragcoefficient + begin);
+                    }
+
+                    if (power) {
+                        for (std::size_t i = 0; i < size; i++) {
+                            auto const v2 = v[i] * v[i];
+                            power[begin + i] = stokescoeff * v2 + inertialcoeff * cd[i] * v2 * std::fabs(v[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // #endregion publicメンバ関数
+}
@@ -0,0 +1,153 @@
+﻿/*! \file observables.h
+    \brief 保存された軌跡から物理量をまとめて求めるクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _OBSERVABLES_H_
+#define _OBSERVABLES_H_
+
+#include "solveeom.h"
+#include <cstddef>                      // for std::size_t
+#include <cstdint>                      // for std::int32_t
+
+namespace solveeom {
+    //! A class.
+    /*!
+        保存された軌跡(θ, ω)の配列から、指定された物理量を一度の走査でまとめて求めるクラス
+        配列をブロックに区切り、ブロックごとに共通の中間量を求めてから各物理量を求める
+    */
+    class Observables final {
+        // #region 列挙型
+
+    public:
+        //!  A enumerated type
+        /*!
+            求める物理量を表す列挙型（ビットの論理和で指定する）
+        */
+        enum class Observable_type : std::int32_t {
+            // 運動エネルギー
+            KINETICENERGY = 1,
+            // ポテンシャルエネルギー
+            POTENTIALENERGY = 1 << 1,
+            // 全エネルギー
+            TOTALENERGY = 1 << 2,
+            // レイノルズ数
+            REYNOLDS = 1 << 3,
+            // 粘性抵抗（符号付き）
+            STOKESFORCE = 1 << 4,
+            // 抗力係数（慣性抵抗を用いない領域では0）
+            DRAGCOEFFICIENT = 1 << 5,
+            // 抵抗により散逸する仕事率
+            DISSIPATEDPOWER = 1 << 6
+        };
+
+        // #endregion 列挙型
+
+        // #region コンストラクタ・デストラクタ
+
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param se 振り子と流体のパラメータを持つSolveEoMオブジェクト
+        */
+        explicit Observables(SolveEoM const & se);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Observables() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function (const).
+        /*!
+            指定された物理量を求める
+            結果は、指定された物理量ごとに要素数nの配列を、Observable_typeの値の小さい順に並べたものになる
+            \param theta θの配列
+            \param omega dθ/dtの配列
+            \param n 配列の要素数
+            \param observables 求める物理量（Observable_typeの論理和）
+            \param result 結果を格納する配列
+        */
+        void operator()(double const * theta, double const * omega, std::size_t n, std::int32_t observables, double * result) const;
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region メンバ変数
+
+        //! A private static member variable (constant expression).
+        /*!
+            一度に処理するブロックの要素数
+        */
+        static auto constexpr BLOCK = 512U;
+
+        //! A private member variable.
+        /*!
+            棒の端から球までの長さ
+        */
+        double const l_;
+
+        //! A private member variable.
+        /*!
+            球の質量
+        */
+        double const m_;
+
+        //! A private member variable.
+        /*!
+            粘度
+        */
+        double const myu_;
+
+        //! A private member variable.
+        /*!
+            流体の動粘度
+        */
+        double const nyu_;
+
+        //! A private member variable.
+        /*!
+            球の半径
+        */
+        double const r_;
+
+        //! A private member variable.
+        /*!
+            流体の密度
+        */
+        double const rho_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        Observables() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Observables(Observables const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Observables & operator=(Observables const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _OBSERVABLES_H_
@@ -0,0 +1,322 @@
+﻿/*! \file parameterfitting.cpp
+    \brief 測定された軌跡に単振り子のパラメータをフィッティングするクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "parameterfitting.h"
+#include "utility/tracer.h"
+#include "utility/workerthreads.h"
+#include <algorithm>                    // for std::max, std::min, std::min_element
+#include <atomic>                       // for std::atomic
+#include <chrono>                       // for std::chrono
+#include <cmath>                        // for std::exp, std::fabs, std::isfinite, std::log, std::sqrt
+#include <exception>                    // for std::current_exception, std::exception_ptr, std::rethrow_exception
+#include <fstream>                      // for std::ifstream
+#include <limits>                       // for std::numeric_limits
+#include <sstream>                      // for std::istringstream
+#include <stdexcept>                    // for std::runtime_error
+#include <tuple>                        // for std::tuple_size
+
+namespace solveeom {
+    // #region コンストラクタ・デストラクタ
+
+    ParameterFitting::ParameterFitting(std::string const & filename, bool resistance, bool simpleharmonic, double v0, double r, double bobrho) :
+        Condition([this] { return condition_; }, nullptr),
+        Elapsed([this] { return elapsed_; }, nullptr),
+        Residual([this] { return residual_; }, nullptr),
+        bobrho_(bobrho),
+        r_(r),
+        resistance_(resistance),
+        simpleharmonic_(simpleharmonic),
+        v0_(v0)
+    {
+        std::ifstream ifs(filename);
+        if (!ifs) {
+            throw std::runtime_error(filename + "が開けませんでした");
+        }
+
+        for (std::string line; std::getline(ifs, line);) {
+            std::istringstream iss(line);
+            double t, theta;
+            char comma;
+            if (iss >> t >> comma >> theta) {
+                t_.push_back(t);
+                theta_.push_back(theta);
+            }
+        }
+
+        if (t_.size() < 2) {
+            throw std::runtime_error(filename + "に測定データがありません");
+        }
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    ParameterFitting::parameter_type ParameterFitting::operator()(std::vector<parameter_type> const & initials, std::int32_t nthreads)
+    {
+        auto const begin = std::chrono::steady_clock::now();
+
+        // 例外が投げられたか、残差が有限にならなかった初期値の結果は、残差を無限大のままにする
+        std::vector<Result> results(initials.size(), { parameter_type(), std::numeric_limits<double>::infinity(), 0.0 });
+        std::vector<std::exception_ptr> errors(initials.size());
+        std::atomic<std::size_t> next(0);
+
+        // 各スレッドはSolveEoMオブジェクトを一つだけ持ち、担当するすべての初期値で使い回す
+        // ある初期値で例外が投げられても、他の初期値からのフィッティングは続ける
+        utility::runthreads(nthreads, [&]
+        {
+            SolveEoM solver(1.0f, 0.05f, resistance_, simpleharmonic_, 0.0f);
+
+            for (auto i = next++; i < initials.size(); i = next++) {
+                try {
+                    auto const result = levenberg_marquardt(solver, initials[i]);
+                    if (std::isfinite(result.residual)) {
+                        results[i] = result;
+                    }
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        });
+
+        auto const best = std::min_element(
+            results.begin(),
+            results.end(),
+            [](auto const & a, auto const & b) { return a.residual < b.residual; });
+
+        elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        if (best == results.end() || best->residual == std::numeric_limits<double>::infinity()) {
+            condition_ = std::numeric_limits<double>::infinity();
+            residual_ = std::numeric_limits<double>::infinity();
+
+            for (auto const & e : errors) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
+            }
+
+            throw std::runtime_error("すべての初期値からのフィッティングで残差が有限になりませんでした");
+        }
+
+        condition_ = best->condition;
+        residual_ = best->residual;
+        return best->parameters;
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    double ParameterFitting::condition_number(std::array<parameter_type, std::tuple_size<parameter_type>::value> a)
+    {
+        auto constexpr N = std::tuple_size<parameter_type>::value;
+
+        // 巡回Jacobi法で非対角成分を消去する
+        for (auto sweep = 0; sweep < 50; sweep++) {
+            auto off = 0.0;
+            for (auto p = 0U; p < N; p++) {
+                for (auto q = p + 1; q < N; q++) {
+                    off += a[p][q] * a[p][q];
+                }
+            }
+
+            if (off == 0.0) {
+                break;
+            }
+
+            for (auto p = 0U; p < N; p++) {
+                for (auto q = p + 1; q < N; q++) {
+                    if (a[p][q] == 0.0) {
+                        continue;
+                    }
+
+                    auto const theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    auto const t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                    auto const c = 1.0 / std::sqrt(t * t + 1.0);
+                    auto const s = t * c;
+
+                    for (auto k = 0U; k < N; k++) {
+                        auto const akp = a[k][p];
+                        auto const akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+
+                    for (auto k = 0U; k < N; k++) {
+                        auto const apk = a[p][k];
+                        auto const aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+                }
+            }
+        }
+
+        auto lmax = a[0][0];
+        auto lmin = a[0][0];
+        for (auto k = 1U; k < N; k++) {
+            lmax = std::max(lmax, a[k][k]);
+            lmin = std::min(lmin, a[k][k]);
+        }
+
+        return lmin > 0.0 ? lmax / lmin : std::numeric_limits<double>::infinity();
+    }
+
+    void ParameterFitting::jacobian(SolveEoM & solver, parameter_type const & q, std::vector<double> const & r, std::vector<double> & theta, std::vector<double> & rh, std::vector<parameter_type> & jac) const
+    {
+        std::vector<double> rm(r.size());
+        for (auto j = 0U; j < std::tuple_size<parameter_type>::value; j++) {
+            auto qh = q;
+            qh[j] += ParameterFitting::H;
+            residuals(solver, qh, theta, rh);
+            qh[j] -= 2.0 * ParameterFitting::H;
+            residuals(solver, qh, theta, rm);
+
+            for (auto i = 0U; i < r.size(); i++) {
+                jac[i][j] = (rh[i] - rm[i]) / (2.0 * ParameterFitting::H);
+            }
+        }
+    }
+
+    ParameterFitting::Result ParameterFitting::levenberg_marquardt(SolveEoM & solver, parameter_type const & initial) const
+    {
+        SOLVEEOM_TRACE_SCOPE("levenberg_marquardt");
+
+        auto constexpr N = std::tuple_size<parameter_type>::value;
+        auto const m = t_.size();
+
+        // 正値のパラメータを扱うため、対数を変数とする
+        parameter_type q;
+        for (auto j = 0U; j < N; j++) {
+            q[j] = std::log(initial[j]);
+        }
+
+        // 作業用の配列は一度だけ確保する
+        std::vector<double> theta, r(m), rtrial(m), rh(m);
+        std::vector<parameter_type> jac(m);
+        theta.reserve(m);
+
+        auto s = residuals(solver, q, theta, r);
+        auto lambda = 1.0E-3;
+
+        // 正規方程式の J^T J と J^T r
+        std::array<parameter_type, N> jtj;
+        parameter_type jtr;
+        auto const normal = [&]
+        {
+            jacobian(solver, q, r, theta, rh, jac);
+
+            jtj = {};
+            jtr = {};
+            for (auto i = 0U; i < m; i++) {
+                for (auto j = 0U; j < N; j++) {
+                    jtr[j] += jac[i][j] * r[i];
+                    for (auto k = 0U; k < N; k++) {
+                        jtj[j][k] += jac[i][j] * jac[i][k];
+                    }
+                }
+            }
+        };
+
+        for (auto iter = 0; iter < ParameterFitting::MAXITER; iter++) {
+            normal();
+
+            auto improved = false;
+            while (lambda < 1.0E+12) {
+                // (J^T J + λ diag(J^T J)) δ = -J^T r をガウスの消去法で解く
+                auto a = jtj;
+                auto delta = jtr;
+                for (auto j = 0U; j < N; j++) {
+                    a[j][j] += lambda * (jtj[j][j] > 0.0 ? jtj[j][j] : 1.0);
+                    delta[j] = -delta[j];
+                }
+
+                for (auto k = 0U; k < N; k++) {
+                    auto pivot = k;
+                    for (auto i = k + 1; i < N; i++) {
+                        if (std::fabs(a[i][k]) > std::fabs(a[pivot][k])) {
+                            pivot = i;
+                        }
+                    }
+                    std::swap(a[k], a[pivot]);
+                    std::swap(delta[k], delta[pivot]);
+
+                    for (auto i = k + 1; i < N; i++) {
+                        auto const f = a[i][k] / a[k][k];
+                        for (auto j = k; j < N; j++) {
+                            a[i][j] -= f * a[k][j];
+                        }
+                        delta[i] -= f * delta[k];
+                    }
+                }
+
+                for (auto k = N; k-- > 0;) {
+                    for (auto j = k + 1; j < N; j++) {
+                        delta[k] -= a[k][j] * delta[j];
+                    }
+                    delta[k] /= a[k][k];
+                }
+
+                auto qtrial = q;
+                auto norm = 0.0;
+                for (auto j = 0U; j < N; j++) {
+                    qtrial[j] += delta[j];
+                    norm = std::max(norm, std::fabs(delta[j]));
+                }
+
+                auto const strial = residuals(solver, qtrial, theta, rtrial);
+                if (strial < s) {
+                    auto const converged = s - strial <= ParameterFitting::TOL * s || norm <= ParameterFitting::TOL;
+
+                    q = qtrial;
+                    s = strial;
+                    r.swap(rtrial);
+                    lambda *= 0.1;
+                    improved = true;
+
+                    if (converged) {
+                        iter = ParameterFitting::MAXITER;
+                    }
+                    break;
+                }
+
+                lambda *= 10.0;
+            }
+
+            if (!improved) {
+                break;
+            }
+        }
+
+        // 解でのJ^T Jから条件数を求める
+        normal();
+
+        parameter_type p;
+        for (auto j = 0U; j < N; j++) {
+            p[j] = std::exp(q[j]);
+        }
+
+        return { p, s, ParameterFitting::condition_number(jtj) };
+    }
+
+    double ParameterFitting::residuals(SolveEoM & solver, parameter_type const & q, std::vector<double> & theta, std::vector<double> & residual) const
+    {
+        solver.reset(std::exp(q[0]), r_, bobrho_, std::exp(q[1]), std::exp(q[2]), theta_[0], v0_);
+        solver.solve(t_, theta);
+
+        auto s = 0.0;
+        for (auto i = 0U; i < t_.size(); i++) {
+            residual[i] = theta[i] - theta_[i];
+            s += residual[i] * residual[i];
+        }
+
+        return s;
+    }
+
+    // #endregion privateメンバ関数
+}
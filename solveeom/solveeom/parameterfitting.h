@@ -0,0 +1,281 @@
+﻿/*! \file parameterfitting.h
+    \brief 測定された軌跡に単振り子のパラメータをフィッティングするクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _PARAMETERFITTING_H_
+#define _PARAMETERFITTING_H_
+
+#include "solveeom.h"
+#include <array>                        // for std::array
+#include <cstdint>                      // for std::int32_t
+#include <string>                       // for std::string
+#include <vector>                       // for std::vector
+
+namespace solveeom {
+    //! A class.
+    /*!
+        測定された軌跡(t, θ)に、Levenberg-Marquardt法で単振り子のパラメータをフィッティングするクラス
+        複数の初期値からの探索を、スレッドごとに使い回すSolveEoMオブジェクトで並列に行う
+        運動方程式は球の質量m ∝ r^3・ρ_bobを通して l, μ/(r^2・ρ_bob), ρ/(r・ρ_bob) の3つの組み合わせにしか依存しないので、
+        球の半径と密度は測定値として与え、ロープの長さ・流体の粘度・流体の密度の3つをフィッティングする
+    */
+    class ParameterFitting final {
+        // #region 型エイリアス
+
+    public:
+        //! A typedef.
+        /*!
+            フィッティングするパラメータ（ロープの長さ, 流体の粘度, 流体の密度）
+        */
+        using parameter_type = std::array<double, 3>;
+
+        // #endregion 型エイリアス
+
+    private:
+        // #region 型
+
+        //! A struct.
+        /*!
+            一つの初期値からのフィッティングの結果
+        */
+        struct Result final {
+            //! A public member variable.
+            /*!
+                フィッティングされたパラメータ
+            */
+            parameter_type parameters;
+
+            //! A public member variable.
+            /*!
+                残差二乗和
+            */
+            double residual;
+
+            //! A public member variable.
+            /*!
+                解でのJ^T Jの条件数
+            */
+            double condition;
+        };
+
+        // #endregion 型
+
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            測定データのファイルは、各行が"t, θ"で始まるCSV形式とする（saveresultの出力も読み込める）
+            \param filename 測定データのファイル名
+            \param resistance 空気抵抗の有無
+            \param simpleharmonic 単振動にするかどうか
+            \param v0 速度の初期値
+            \param r 球の半径（測定値）
+            \param bobrho 球の密度（測定値）
+        */
+        ParameterFitting(std::string const & filename, bool resistance, bool simpleharmonic, double v0, double r, double bobrho);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~ParameterFitting() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            与えられた各初期値からフィッティングを行い、残差が最小となったパラメータを返す
+            一部の初期値からの探索が失敗しても残りの結果を用い、すべてで失敗したときは例外を投げる（スレッド内の例外は最初のものを投げ直す）
+            \param initials パラメータの初期値の配列
+            \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+            \return フィッティングされたパラメータ
+        */
+        parameter_type operator()(std::vector<parameter_type> const & initials, std::int32_t nthreads);
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function.
+        /*!
+            パラメータ（の対数）に対するヤコビアンを中心差分で求める
+            \param solver 使い回すSolveEoMオブジェクト
+            \param q パラメータの対数
+            \param r qでの残差
+            \param theta 作業用の配列
+            \param rh 作業用の配列
+            \param jac ヤコビアンを格納する配列
+        */
+        void jacobian(SolveEoM & solver, parameter_type const & q, std::vector<double> const & r, std::vector<double> & theta, std::vector<double> & rh, std::vector<parameter_type> & jac) const;
+
+        //! A private member function.
+        /*!
+            一つの初期値から、Levenberg-Marquardt法でフィッティングを行う
+            \param solver 使い回すSolveEoMオブジェクト
+            \param initial パラメータの初期値
+            \return フィッティングの結果
+        */
+        Result levenberg_marquardt(SolveEoM & solver, parameter_type const & initial) const;
+
+        //! A private member function.
+        /*!
+            パラメータ（の対数）に対する残差を求める
+            \param solver 使い回すSolveEoMオブジェクト
+            \param q パラメータの対数
+            \param theta 作業用の配列
+            \param residual 残差を格納する配列
+            \return 残差二乗和
+        */
+        double residuals(SolveEoM & solver, parameter_type const & q, std::vector<double> & theta, std::vector<double> & residual) const;
+
+        //! A private static member function.
+        /*!
+            対称行列の条件数（最大固有値÷最小固有値）をJacobi法で求める
+            \param a 対称行列
+            \return 条件数（最小固有値が0以下なら無限大）
+        */
+        static double condition_number(std::array<parameter_type, std::tuple_size<parameter_type>::value> a);
+
+        // #endregion privateメンバ関数
+
+        // #region プロパティ
+
+    public:
+        //! A property.
+        /*!
+            直前のフィッティングの解での、パラメータの対数に対するJ^T Jの条件数へのプロパティ
+            大きいほど、パラメータが測定データから決まりにくいことを表す
+        */
+        Property<double> Condition;
+
+        //! A property.
+        /*!
+            直前のフィッティングにかかった時間（秒）へのプロパティ
+        */
+        Property<double> Elapsed;
+
+        //! A property.
+        /*!
+            直前のフィッティングの残差二乗和へのプロパティ
+        */
+        Property<double> Residual;
+
+        // #endregion プロパティ
+
+        // #region メンバ変数
+
+    private:
+        //! A private static member variable (constant expression).
+        /*!
+            Levenberg-Marquardt法の最大反復回数
+        */
+        static auto constexpr MAXITER = 200;
+
+        //! A private static member variable (constant expression).
+        /*!
+            数値微分の刻み幅（パラメータの対数に対する）
+        */
+        static auto constexpr H = 1.0E-4;
+
+        //! A private static member variable (constant expression).
+        /*!
+            収束判定の許容誤差
+        */
+        static auto constexpr TOL = 1.0E-12;
+
+        //! A private member variable.
+        /*!
+            球の密度（測定値）
+        */
+        double bobrho_;
+
+        //! A private member variable.
+        /*!
+            直前のフィッティングの解でのJ^T Jの条件数
+        */
+        double condition_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            直前のフィッティングにかかった時間（秒）
+        */
+        double elapsed_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            球の半径（測定値）
+        */
+        double r_;
+
+        //! A private member variable.
+        /*!
+            空気抵抗の有無
+        */
+        bool resistance_;
+
+        //! A private member variable.
+        /*!
+            直前のフィッティングの残差二乗和
+        */
+        double residual_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            単振動にするかどうか
+        */
+        bool simpleharmonic_;
+
+        //! A private member variable.
+        /*!
+            測定時刻の配列
+        */
+        std::vector<double> t_;
+
+        //! A private member variable.
+        /*!
+            測定されたθの配列
+        */
+        std::vector<double> theta_;
+
+        //! A private member variable.
+        /*!
+            速度の初期値
+        */
+        double v0_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        ParameterFitting() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        ParameterFitting(ParameterFitting const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        ParameterFitting & operator=(ParameterFitting const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _PARAMETERFITTING_H_
@@ -0,0 +1,136 @@
+﻿/*! \file parareal.cpp
+    \brief Parareal法で運動方程式を時間方向に並列に積分するクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "parareal.h"
+#include "utility/tracer.h"
+#include "utility/workerthreads.h"
+#include <algorithm>                    // for std::max
+#include <atomic>                       // for std::atomic
+#include <chrono>                       // for std::chrono
+#include <cmath>                        // for std::ceil, std::fabs, std::isfinite
+#include <stdexcept>                    // for std::runtime_error
+
+namespace solveeom {
+    // #region コンストラクタ・デストラクタ
+
+    Parareal::Parareal(SolveEoM const & se) :
+        Correction([this] { return correction_; }, nullptr),
+        Elapsed([this] { return elapsed_; }, nullptr),
+        Iterations([this] { return iterations_; }, nullptr),
+        se_(se)
+    {
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    SolveEoM::state_type Parareal::operator()(double t, std::int32_t nslices, double coarsedt, double tol, std::int32_t nthreads)
+    {
+        // coarsedtが0以下だと粗い解法のステップ数が無限大になり、std::size_tに変換できない
+        if (!std::isfinite(t) || t < 0.0 || nslices <= 0 || !(coarsedt > 0.0) || !(t / coarsedt < 1.0E+15) || !(tol >= 0.0)) {
+            throw std::runtime_error("Parareal法の引数が正しくありません");
+        }
+
+        auto const begin = std::chrono::steady_clock::now();
+
+        coarsedt_ = coarsedt;
+        auto const n = static_cast<std::size_t>(nslices);
+
+        // スライスの境界の時刻
+        std::vector<double> times(n + 1);
+        for (auto k = 0U; k <= n; k++) {
+            times[k] = t * static_cast<double>(k) / static_cast<double>(n);
+        }
+
+        // スライス境界での状態と、それに対する粗い解法・精密な解法の結果
+        std::vector<SolveEoM::state_type> u(n + 1), g(n), f(n);
+        u[0] = se_.x_;
+
+        // 粗い解法による最初の予測
+        for (auto k = 0U; k < n; k++) {
+            g[k] = coarse(u[k], times[k], times[k + 1]);
+            u[k + 1] = g[k];
+        }
+
+        correction_ = 0.0;
+        iterations_ = 0;
+
+        // 反復kの後では、最初のk個のスライスの終点は精密な解法の結果に一致している
+        for (auto iter = 0U; iter < n; iter++) {
+            // 精密な解法による各スライスの積分を並列に行う
+            std::atomic<std::size_t> next(iter);
+            utility::runthreads(nthreads, [&]
+            {
+                for (auto k = next++; k < n; k = next++) {
+                    f[k] = fine(u[k], times[k], times[k + 1]);
+                }
+            });
+
+            // 粗い解法による修正を逐次に行う U[k+1] = G(U[k]) + F(U_old[k]) - G(U_old[k])
+            // スライスiterの始点は変わらないので、その粗い解法の結果は計算し直さない
+            correction_ = 0.0;
+            for (auto k = iter; k < n; k++) {
+                auto const gnew = k == iter ? g[k] : coarse(u[k], times[k], times[k + 1]);
+
+                for (auto j = 0U; j < u[k + 1].size(); j++) {
+                    auto const unew = gnew[j] + f[k][j] - g[k][j];
+                    correction_ = std::max(correction_, std::fabs(unew - u[k + 1][j]));
+                    u[k + 1][j] = unew;
+                }
+
+                g[k] = gnew;
+            }
+
+            iterations_ = static_cast<std::int32_t>(iter + 1);
+
+            if (correction_ <= tol) {
+                break;
+            }
+        }
+
+        elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        return u[n];
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    SolveEoM::state_type Parareal::coarse(SolveEoM::state_type x, double t0, double t1) const
+    {
+        // スライスの長さを割り切る、coarsedt_以下の刻み幅で積分する
+        auto const steps = std::max(static_cast<std::size_t>(std::ceil((t1 - t0) / coarsedt_)), static_cast<std::size_t>(1));
+
+        boost::numeric::odeint::integrate_n_steps(
+            boost::numeric::odeint::runge_kutta4<SolveEoM::state_type>(),
+            se_.getEOM(),
+            x,
+            t0,
+            (t1 - t0) / static_cast<double>(steps),
+            steps);
+
+        return x;
+    }
+
+    SolveEoM::state_type Parareal::fine(SolveEoM::state_type x, double t0, double t1) const
+    {
+        SOLVEEOM_TRACE_SCOPE("parareal_fine");
+
+        boost::numeric::odeint::integrate_adaptive(
+            boost::numeric::odeint::bulirsch_stoer<SolveEoM::state_type>(SolveEoM::EPS, SolveEoM::EPS),
+            se_.getEOM(),
+            x,
+            t0,
+            t1,
+            SolveEoM::DX);
+
+        return x;
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,168 @@
+﻿/*! \file parareal.h
+    \brief Parareal法で運動方程式を時間方向に並列に積分するクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _PARAREAL_H_
+#define _PARAREAL_H_
+
+#include "solveeom.h"
+#include <cstdint>                      // for std::int32_t
+#include <vector>                       // for std::vector
+
+namespace solveeom {
+    //! A class.
+    /*!
+        Parareal法で、一本の長い軌跡を時間方向に並列に積分するクラス
+        積分区間をスライスに分け、安価な粗い解法（固定刻みの4次Runge-Kutta法）で全体を逐次に予測し、
+        精密な解法（Bulirsch-Stoer法）による各スライスの積分を並列に行って予測を修正する
+        反復をスライスの数だけ行えば、各スライスを精密な解法で逐次に積分した結果と一致する
+    */
+    class Parareal final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            seの現在の状態を初期値とし、seの状態は変更しない
+            \param se 積分するSolveEoMオブジェクト
+        */
+        explicit Parareal(SolveEoM const & se);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Parareal() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            運動方程式を時刻tまで積分する
+            引数が正しくないか、いずれかのスライスで積分に失敗したときはstd::runtime_errorなどの例外を投げる
+            \param t 指定時間（0以上）
+            \param nslices スライスの数（正）
+            \param coarsedt 粗い解法の時間刻み（正）
+            \param tol 反復の収束判定の許容誤差（スライス境界での状態の修正量の最大値、0以上）
+            \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+            \return 時刻tでの状態(θ, dθ/dt)
+        */
+        SolveEoM::state_type operator()(double t, std::int32_t nslices, double coarsedt, double tol, std::int32_t nthreads);
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function (const).
+        /*!
+            粗い解法で一つのスライスを積分する
+            \param x スライスの始点での状態
+            \param t0 スライスの始点の時刻
+            \param t1 スライスの終点の時刻
+            \return スライスの終点での状態
+        */
+        SolveEoM::state_type coarse(SolveEoM::state_type x, double t0, double t1) const;
+
+        //! A private member function (const).
+        /*!
+            精密な解法で一つのスライスを積分する
+            \param x スライスの始点での状態
+            \param t0 スライスの始点の時刻
+            \param t1 スライスの終点の時刻
+            \return スライスの終点での状態
+        */
+        SolveEoM::state_type fine(SolveEoM::state_type x, double t0, double t1) const;
+
+        // #endregion privateメンバ関数
+
+        // #region プロパティ
+
+    public:
+        //! A property.
+        /*!
+            直前の反復での、スライス境界での状態の修正量の最大値へのプロパティ
+        */
+        Property<double> Correction;
+
+        //! A property.
+        /*!
+            直前の積分にかかった時間（秒）へのプロパティ
+        */
+        Property<double> Elapsed;
+
+        //! A property.
+        /*!
+            直前の積分での反復回数へのプロパティ
+        */
+        Property<std::int32_t> Iterations;
+
+        // #endregion プロパティ
+
+        // #region メンバ変数
+
+    private:
+        //! A private member variable.
+        /*!
+            粗い解法の時間刻み
+        */
+        double coarsedt_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            直前の反復での、スライス境界での状態の修正量の最大値
+        */
+        double correction_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            直前の積分にかかった時間（秒）
+        */
+        double elapsed_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            直前の積分での反復回数
+        */
+        std::int32_t iterations_ = 0;
+
+        //! A private member variable.
+        /*!
+            積分するSolveEoMオブジェクト
+        */
+        SolveEoM const & se_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        Parareal() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Parareal(Parareal const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Parareal & operator=(Parareal const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _PARAREAL_H_
@@ -0,0 +1,150 @@
+﻿/*! \file poincaresection.cpp
+    \brief 駆動振り子のポアンカレ断面を求めるクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "poincaresection.h"
+#include "utility/tracer.h"
+#include "utility/workerthreads.h"
+#include <atomic>                               // for std::atomic
+#include <chrono>                               // for std::chrono
+#include <cmath>                                // for std::remainder
+#include <stdexcept>                            // for std::runtime_error
+#include <boost/math/constants/constants.hpp>   // for boost::math::constants::pi
+
+namespace solveeom {
+    // #region コンストラクタ・デストラクタ
+
+    PoincareSection::PoincareSection(SolveEoM const & se) :
+        Elapsed([this] { return elapsed_; }, nullptr),
+        bobrho_(se.m_ / (4.0 / 3.0 * boost::math::constants::pi<double>() * se.r_ * se.r_ * se.r_)),
+        drivefrequency_(se.drivefrequency_),
+        drivephase_(se.drivefrequency_ * se.t_ + se.drivephase_),
+        l_(se.l_),
+        myu_(se.myu_),
+        omega0_(se.x_[1]),
+        r_(se.r_),
+        resistance_(se.resistance_),
+        rho_(se.rho_),
+        simpleharmonic_(se.simpleharmonic_),
+        theta0_(se.x_[0])
+    {
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    void PoincareSection::operator()(std::vector<double> const & amplitudes, std::int64_t transient, std::int64_t periods, std::string const & filename, std::int32_t nthreads)
+    {
+        if (drivefrequency_ <= 0.0) {
+            throw std::runtime_error("駆動力の角振動数が設定されていません");
+        }
+
+        if (amplitudes.empty() || transient < 0 || periods <= 0) {
+            throw std::runtime_error("振幅の数、または周期の数が正しくありません");
+        }
+
+        auto const begin = std::chrono::steady_clock::now();
+
+        ofs_.open(filename, std::ios::binary | std::ios::trunc);
+        if (!ofs_) {
+            throw std::runtime_error(filename + "が開けませんでした");
+        }
+
+        auto const n = static_cast<std::uint32_t>(amplitudes.size());
+        ofs_.write(POINCAREMAGIC.data(), POINCAREMAGIC.size());
+        ofs_.write(reinterpret_cast<char const *>(&n), sizeof(n));
+        ofs_.write(reinterpret_cast<char const *>(amplitudes.data()), sizeof(double) * n);
+
+        std::atomic<std::uint32_t> next(0);
+
+        // SolveEoMオブジェクトはスレッドごとに一つ作り、振幅ごとにreset()する
+        // reset()で時刻は0に戻るので、seの現在の時刻での位相を初期位相として渡す
+        // 一つでも失敗すればファイルは不完全になるので、残りの振幅は処理しない
+        auto const worker = [&]
+        {
+            try {
+                SolveEoM solver(1.0f, 0.05f, resistance_, simpleharmonic_, 0.0f);
+
+                for (auto i = next++; i < n; i = next++) {
+                    solver.reset(l_, r_, bobrho_, myu_, rho_, theta0_, l_ * omega0_);
+                    solver.setdrive(amplitudes[i], drivefrequency_, drivephase_);
+                    section(solver, i, transient, periods);
+                }
+            }
+            catch (...) {
+                next = n;
+                throw;
+            }
+        };
+
+        utility::runthreads(nthreads, worker);
+        ofs_.close();
+
+        elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    void PoincareSection::flush(std::uint32_t index, std::vector<point_type> & chunk)
+    {
+        if (chunk.empty()) {
+            return;
+        }
+
+        auto const m = static_cast<std::uint32_t>(chunk.size());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            ofs_.write(reinterpret_cast<char const *>(&index), sizeof(index));
+            ofs_.write(reinterpret_cast<char const *>(&m), sizeof(m));
+            ofs_.write(reinterpret_cast<char const *>(chunk.data()), sizeof(point_type) * m);
+        }
+
+        chunk.clear();
+    }
+
+    void PoincareSection::section(SolveEoM const & solver, std::uint32_t index, std::int64_t transient, std::int64_t periods)
+    {
+        SOLVEEOM_TRACE_SCOPE("poincare_section");
+
+        auto const twopi = 2.0 * boost::math::constants::pi<double>();
+        auto const period = twopi / drivefrequency_;
+
+        std::vector<point_type> chunk;
+        chunk.reserve(PoincareSection::CHUNK);
+
+        // 観測は時刻0から始まるので、transient + 1回目までは捨てる
+        std::int64_t count = 0;
+        auto x = solver.x_;
+
+        // 周期ごとの時刻k・periodでの状態は、密出力の補間で求める
+        boost::numeric::odeint::integrate_n_steps(
+            boost::numeric::odeint::bulirsch_stoer_dense_out<SolveEoM::state_type>(SolveEoM::EPS, SolveEoM::EPS),
+            solver.getEOM(),
+            x,
+            0.0,
+            period,
+            transient + periods,
+            [&](auto const & x, auto const)
+            {
+                if (count++ <= transient) {
+                    return;
+                }
+
+                chunk.push_back({ static_cast<float>(std::remainder(x[0], twopi)), static_cast<float>(x[1]) });
+                if (chunk.size() == PoincareSection::CHUNK) {
+                    flush(index, chunk);
+                }
+            });
+
+        flush(index, chunk);
+    }
+
+    // #endregion privateメンバ関数
+}
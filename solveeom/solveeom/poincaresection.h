@@ -0,0 +1,237 @@
+﻿/*! \file poincaresection.h
+    \brief 駆動振り子のポアンカレ断面を求めるクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _POINCARESECTION_H_
+#define _POINCARESECTION_H_
+
+#include "solveeom.h"
+#include <array>                        // for std::array
+#include <cstdint>                      // for std::int32_t, std::int64_t, std::uint32_t
+#include <fstream>                      // for std::ofstream
+#include <mutex>                        // for std::mutex
+#include <string>                       // for std::string
+#include <vector>                       // for std::vector
+
+namespace solveeom {
+    //! A global variable (constant expression).
+    /*!
+        ポアンカレ断面ファイルの先頭に書かれるマジックナンバー
+    */
+    static std::array<char, 8> constexpr POINCAREMAGIC = { 'S', 'E', 'O', 'M', 'P', 'N', 'C', '1' };
+
+    //! A class.
+    /*!
+        駆動振り子の状態を駆動力の一周期ごとに一度だけ求め、ポアンカレ断面をバイナリ形式で保存するクラス
+        周期ごとの状態は密出力の補間で求めるので、時間刻みを周期に合わせて細かくする必要はない
+        複数の駆動力の振幅を、スレッドごとに使い回すSolveEoMオブジェクトで並列に処理する
+
+        ファイルは、マジックナンバー、振幅の数n（std::uint32_t）、n個の振幅（double）の後に、
+        チャンク（振幅の番号（std::uint32_t）、点の数m（std::uint32_t）、m個の(θ, dθ/dt)（float×2））が続く
+        一つの振幅の点は順に書かれるが、異なる振幅のチャンクは入り混じる
+    */
+    class PoincareSection final {
+        // #region 型エイリアス
+
+    public:
+        //! A typedef.
+        /*!
+            ポアンカレ断面上の点（[-π, π]に収めたθ, dθ/dt）
+        */
+        using point_type = std::array<float, 2>;
+
+        // #endregion 型エイリアス
+
+        // #region コンストラクタ・デストラクタ
+
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            振り子と流体のパラメータ、現在の状態、駆動力の角振動数と位相をseから受け取る
+            位相はseの現在の時刻でのものを受け取り、ポアンカレ断面はその時刻を0として周期ごとに取る
+            \param se 振り子と流体のパラメータを持つSolveEoMオブジェクト
+        */
+        explicit PoincareSection(SolveEoM const & se);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~PoincareSection() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            各振幅についてポアンカレ断面を求め、ファイルに保存する
+            引数が正しくないか、いずれかの振幅で積分に失敗したときはstd::runtime_errorなどの例外を投げる
+            \param amplitudes 駆動力の振幅の配列
+            \param transient 捨てる過渡状態の周期の数
+            \param periods 保存する周期の数
+            \param filename 保存ファイル名
+            \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+        */
+        void operator()(std::vector<double> const & amplitudes, std::int64_t transient, std::int64_t periods, std::string const & filename, std::int32_t nthreads);
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function.
+        /*!
+            チャンクをファイルに書き込み、空にする
+            \param index 振幅の番号
+            \param chunk 書き込む点の配列
+        */
+        void flush(std::uint32_t index, std::vector<point_type> & chunk);
+
+        //! A private member function.
+        /*!
+            一つの振幅について、周期ごとの点を求めてファイルに書き込む
+            \param solver 駆動力を設定したSolveEoMオブジェクト
+            \param index 振幅の番号
+            \param transient 捨てる過渡状態の周期の数
+            \param periods 保存する周期の数
+        */
+        void section(SolveEoM const & solver, std::uint32_t index, std::int64_t transient, std::int64_t periods);
+
+        // #endregion privateメンバ関数
+
+        // #region プロパティ
+
+    public:
+        //! A property.
+        /*!
+            直前の計算にかかった時間（秒）へのプロパティ
+        */
+        Property<double> Elapsed;
+
+        // #endregion プロパティ
+
+        // #region メンバ変数
+
+    private:
+        //! A private static member variable (constant expression).
+        /*!
+            一度に書き込むチャンクの点の数
+        */
+        static auto constexpr CHUNK = 4096U;
+
+        //! A private member variable.
+        /*!
+            球の密度
+        */
+        double const bobrho_;
+
+        //! A private member variable.
+        /*!
+            駆動力の角振動数
+        */
+        double const drivefrequency_;
+
+        //! A private member variable.
+        /*!
+            駆動力の初期位相（seの現在の時刻での位相）
+        */
+        double const drivephase_;
+
+        //! A private member variable.
+        /*!
+            直前の計算にかかった時間（秒）
+        */
+        double elapsed_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            棒の端から球までの長さ
+        */
+        double const l_;
+
+        //! A private member variable.
+        /*!
+            粘度
+        */
+        double const myu_;
+
+        //! A private member variable.
+        /*!
+            ofs_を保護するミューテックス
+        */
+        std::mutex mutex_;
+
+        //! A private member variable.
+        /*!
+            保存ファイルのストリーム
+        */
+        std::ofstream ofs_;
+
+        //! A private member variable.
+        /*!
+            dθ/dtの初期値
+        */
+        double const omega0_;
+
+        //! A private member variable.
+        /*!
+            球の半径
+        */
+        double const r_;
+
+        //! A private member variable.
+        /*!
+            空気抵抗の有無
+        */
+        bool const resistance_;
+
+        //! A private member variable.
+        /*!
+            流体の密度
+        */
+        double const rho_;
+
+        //! A private member variable.
+        /*!
+            単振動にするかどうか
+        */
+        bool const simpleharmonic_;
+
+        //! A private member variable.
+        /*!
+            θの初期値
+        */
+        double const theta0_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        PoincareSection() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        PoincareSection(PoincareSection const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        PoincareSection & operator=(PoincareSection const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _POINCARESECTION_H_
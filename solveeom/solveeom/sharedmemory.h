@@ -0,0 +1,252 @@
+﻿/*! \file sharedmemory.h
+    \brief シミュレーションサーバーの共有メモリを作成・接続するクラスの宣言と実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _SHAREDMEMORY_H_
+#define _SHAREDMEMORY_H_
+
+#pragma once
+
+#include "sharedstate.h"
+#include <cstdint>                                          // for std::int32_t
+#include <new>                                              // for placement new
+#include <boost/interprocess/exceptions.hpp>                // for boost::interprocess::interprocess_exception
+#include <boost/interprocess/mapped_region.hpp>             // for boost::interprocess::mapped_region
+
+#ifdef _WIN32
+#include <boost/interprocess/windows_shared_memory.hpp>     // for boost::interprocess::windows_shared_memory
+#else
+#include <cerrno>                                           // for errno, EPERM
+#include <signal.h>                                         // for kill
+#include <unistd.h>                                         // for getpid
+#include <boost/interprocess/shared_memory_object.hpp>      // for boost::interprocess::shared_memory_object
+#endif
+
+namespace solveeom {
+    //! A class.
+    /*!
+        シミュレーションサーバーの共有メモリ（SharedState）を作成、または既存のものに接続するクラス
+        WindowsではBoostのファイルによるエミュレーションではなく、ネイティブな名前付きファイルマッピングを用いるので、
+        C++以外（.NETのMemoryMappedFileなど）からも同じ名前で開ける
+    */
+    class SharedMemory final {
+        // #region 型エイリアス
+
+#ifdef _WIN32
+        //! A typedef.
+        /*!
+            ネイティブな名前付きファイルマッピング（最後のハンドルが閉じられると消える）
+        */
+        using shm_type = boost::interprocess::windows_shared_memory;
+#else
+        //! A typedef.
+        /*!
+            POSIXの共有メモリ（shm_open）
+        */
+        using shm_type = boost::interprocess::shared_memory_object;
+#endif
+
+        // #endregion 型エイリアス
+
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            共有メモリを作成して初期化する（サーバーが用いる）
+            \param ninstances SolveEoMオブジェクトの数
+        */
+        SharedMemory(boost::interprocess::create_only_t, std::int32_t ninstances);
+
+        //! A constructor.
+        /*!
+            既存の共有メモリに接続する（クライアントが用いる）
+            サーバーが動いていないか、初期化を終えていなければboost::interprocess::interprocess_exceptionを投げる
+        */
+        explicit SharedMemory(boost::interprocess::open_only_t);
+
+        //! A destructor.
+        /*!
+            作成した側であれば共有メモリを削除する
+        */
+        ~SharedMemory();
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function (const).
+        /*!
+            共有メモリ上の構造を返す
+            \return 共有メモリ上の構造
+        */
+        SharedState & operator*() const;
+
+        //! A public member function (const).
+        /*!
+            共有メモリ上の構造へのポインタを返す
+            \return 共有メモリ上の構造へのポインタ
+        */
+        SharedState * operator->() const;
+
+        //! A public static member function.
+        /*!
+            前回異常終了したときに残った共有メモリを削除する（Windowsでは何もしない）
+            動いているサーバーの共有メモリも削除してしまうので、先にrunning()で調べておくこと
+        */
+        static void remove();
+
+        //! A public static member function.
+        /*!
+            共有メモリを作成したサーバーが動いているかどうかを調べる
+            Windowsでは共有メモリは最後のハンドルが閉じられると消えるので、初期化を終えた共有メモリが開ければ動いているとみなす
+            POSIXでは共有メモリに書かれたプロセスIDのプロセスが存在するかどうかを調べる
+            \return サーバーが動いていればtrue
+        */
+        static bool running();
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region メンバ変数
+
+        //! A private member variable.
+        /*!
+            作成した側かどうか
+        */
+        bool const owner_;
+
+        //! A private member variable.
+        /*!
+            共有メモリ
+        */
+        shm_type shm_;
+
+        //! A private member variable.
+        /*!
+            共有メモリをマップした領域
+        */
+        boost::interprocess::mapped_region region_;
+
+        //! A private member variable.
+        /*!
+            共有メモリ上の構造
+        */
+        SharedState * state_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        SharedMemory() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        SharedMemory(SharedMemory const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        SharedMemory & operator=(SharedMemory const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+
+    // #region コンストラクタ・デストラクタの実装
+
+#ifdef _WIN32
+    inline SharedMemory::SharedMemory(boost::interprocess::create_only_t, std::int32_t ninstances) :
+        owner_(true),
+        shm_(boost::interprocess::create_only, SHAREDSTATENAME, boost::interprocess::read_write, sizeof(SharedState)),
+        region_(shm_, boost::interprocess::read_write),
+        state_(new(region_.get_address()) SharedState)
+    {
+        state_->serverpid = 0;
+        state_->initialize(ninstances);
+    }
+#else
+    inline SharedMemory::SharedMemory(boost::interprocess::create_only_t, std::int32_t ninstances) :
+        owner_(true),
+        shm_(boost::interprocess::create_only, SHAREDSTATENAME, boost::interprocess::read_write)
+    {
+        shm_.truncate(sizeof(SharedState));
+        region_ = boost::interprocess::mapped_region(shm_, boost::interprocess::read_write);
+        state_ = new(region_.get_address()) SharedState;
+        state_->serverpid = static_cast<std::int64_t>(::getpid());
+        state_->initialize(ninstances);
+    }
+#endif
+
+    inline SharedMemory::SharedMemory(boost::interprocess::open_only_t) :
+        owner_(false),
+        shm_(boost::interprocess::open_only, SHAREDSTATENAME, boost::interprocess::read_write),
+        region_(shm_, boost::interprocess::read_write),
+        state_(static_cast<SharedState *>(region_.get_address()))
+    {
+        if (region_.get_size() < sizeof(SharedState) || !state_->initialized()) {
+            throw boost::interprocess::interprocess_exception("共有メモリが初期化されていません");
+        }
+    }
+
+    inline SharedMemory::~SharedMemory()
+    {
+        if (owner_) {
+            SharedMemory::remove();
+        }
+    }
+
+    // #endregion コンストラクタ・デストラクタの実装
+
+    // #region メンバ関数の実装
+
+    inline SharedState & SharedMemory::operator*() const
+    {
+        return *state_;
+    }
+
+    inline SharedState * SharedMemory::operator->() const
+    {
+        return state_;
+    }
+
+    inline void SharedMemory::remove()
+    {
+#ifndef _WIN32
+        boost::interprocess::shared_memory_object::remove(SHAREDSTATENAME);
+#endif
+    }
+
+    inline bool SharedMemory::running()
+    {
+        try {
+            SharedMemory const shared(boost::interprocess::open_only);
+
+#ifdef _WIN32
+            return true;
+#else
+            // シグナルは送らず、プロセスの存在だけを調べる
+            auto const pid = static_cast<pid_t>(shared->serverpid);
+            return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+#endif
+        }
+        catch (boost::interprocess::interprocess_exception const &) {
+            // 共有メモリがないか、初期化を終えていない
+            return false;
+        }
+    }
+
+    // #endregion メンバ関数の実装
+}
+
+#endif  // _SHAREDMEMORY_H_
@@ -0,0 +1,502 @@
+﻿/*! \file sharedstate.h
+    \brief シミュレーションサーバーが状態を公開する共有メモリの構造の宣言と実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _SHAREDSTATE_H_
+#define _SHAREDSTATE_H_
+
+#pragma once
+
+#include <atomic>       // for std::atomic, std::atomic_thread_fence
+#include <cmath>        // for std::isfinite
+#include <cstdint>      // for std::int32_t, std::int64_t, std::uint32_t, std::uint64_t
+
+namespace solveeom {
+    //! A global variable (constant expression).
+    /*!
+        状態を公開し、コマンドを受け付ける共有メモリの名前
+        WindowsではOSのネイティブな名前付きファイルマッピング（.NETのMemoryMappedFile.OpenExistingで開ける）、
+        それ以外ではPOSIXの共有メモリ（shm_open）の名前になる
+    */
+    static auto constexpr SHAREDSTATENAME = "solveeom_sharedstate";
+
+    //!  A enumerated type
+    /*!
+        サーバーへのコマンドの種類を表す列挙型
+    */
+    enum class Command_type : std::int32_t {
+        // θを設定する
+        SETTHETA = 0,
+        // 速度を設定する
+        SETV = 1,
+        // 流体の種類を設定する
+        SETFLUID = 2,
+        // 空気抵抗の有無を設定する
+        SETRESISTANCE = 3,
+        // 単振動にするかどうかを設定する
+        SETSIMPLEHARMONIC = 4,
+        // サーバーを終了する
+        QUIT = 5
+    };
+
+    //! A struct.
+    /*!
+        サーバーへのコマンド
+    */
+    struct Command final {
+        // #region publicメンバ関数
+
+        //! A public member function (const).
+        /*!
+            他のプロセスから送られたコマンドとして正しいかどうかを調べる
+            \param ninstances SolveEoMオブジェクトの数
+            \return 正しいコマンドかどうか
+        */
+        bool valid(std::int32_t ninstances) const;
+
+        // #endregion publicメンバ関数
+
+        // #region メンバ変数
+
+        //! A public member variable.
+        /*!
+            コマンドの種類
+        */
+        Command_type type;
+
+        //! A public member variable.
+        /*!
+            対象のSolveEoMオブジェクトの番号
+        */
+        std::int32_t instance;
+
+        //! A public member variable.
+        /*!
+            設定する値（bool値は0か1、流体の種類はsetfluidの引数）
+        */
+        double value;
+
+        // #endregion メンバ変数
+    };
+
+    //! A struct.
+    /*!
+        共有メモリに公開される、ある時刻での一つの振り子の状態
+    */
+    struct SharedSample final {
+        //! A public member variable.
+        /*!
+            公開された順の通し番号
+        */
+        std::uint64_t index;
+
+        //! A public member variable.
+        /*!
+            公開した時刻（std::chrono::steady_clockのナノ秒）
+        */
+        std::int64_t timestamp;
+
+        //! A public member variable.
+        /*!
+            シミュレーション内の時刻
+        */
+        double time;
+
+        //! A public member variable.
+        /*!
+            SolveEoMオブジェクトの番号
+        */
+        std::int32_t instance;
+
+        //! A public member variable.
+        /*!
+            角度θ
+        */
+        float theta;
+
+        //! A public member variable.
+        /*!
+            速度v
+        */
+        float v;
+
+        //! A public member variable.
+        /*!
+            運動エネルギー
+        */
+        float kinetic_energy;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギー
+        */
+        float potential_energy;
+    };
+
+    //! A struct.
+    /*!
+        共有メモリ上のリングバッファ
+        書き込みは一つのプロセスのみが行い、各スロットはseqlock（奇数なら書き込み中）で保護される
+    */
+    struct SharedRing final {
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            リングバッファを初期化する（サーバーのみが呼ぶ）
+            \param ninstances SolveEoMオブジェクトの数
+        */
+        void initialize(std::int32_t ninstances);
+
+        //! A public member function (const).
+        /*!
+            これまでに公開された状態の数を返す
+            \return 公開された状態の数
+        */
+        std::uint64_t published() const;
+
+        //! A public member function (const).
+        /*!
+            通し番号indexの状態を読み出す
+            \param index 通し番号
+            \param sample 読み出した状態
+            \return 読み出せたかどうか（まだ公開されていないか、既に上書きされているか、
+                    MAXRETRIES回試しても書き込み中のままであればfalse）
+        */
+        bool read(std::uint64_t index, SharedSample & sample) const;
+
+        //! A public member function.
+        /*!
+            状態を公開する（サーバーのみが呼ぶ）
+            \param sample 公開する状態（indexは上書きされる）
+        */
+        void write(SharedSample sample);
+
+        // #endregion publicメンバ関数
+
+        // #region メンバ変数
+
+        //! A public static member variable (constant expression).
+        /*!
+            リングバッファのスロット数
+        */
+        static auto constexpr CAPACITY = 4096U;
+
+        //! A public static member variable (constant expression).
+        /*!
+            書き込み中のスロットを読み直す最大の回数
+            サーバーが書き込みの途中で落ちると、そのスロットは書き込み中のまま残るので、無限には待たない
+        */
+        static auto constexpr MAXRETRIES = 1024U;
+
+        //! A public member variable.
+        /*!
+            SolveEoMオブジェクトの数
+        */
+        std::int32_t ninstances;
+
+        //! A public member variable.
+        /*!
+            これまでに公開された状態の数
+        */
+        std::atomic<std::uint64_t> head;
+
+        //! A public member variable.
+        /*!
+            各スロットのseqlockのカウンタ
+        */
+        std::atomic<std::uint32_t> sequence[CAPACITY];
+
+        //! A public member variable.
+        /*!
+            各スロットの状態
+        */
+        SharedSample slots[CAPACITY];
+
+        // #endregion メンバ変数
+    };
+
+    //! A struct.
+    /*!
+        共有メモリ上の、コマンドを受け付ける固定長のキュー
+        任意の数のプロセスが書き込み、サーバーのみが読み出す
+        各スロットの通し番号が、書き込み可能（番号 = 位置）か読み出し可能（番号 = 位置 + 1）かを表す
+    */
+    struct SharedCommandQueue final {
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            キューを初期化する（サーバーのみが呼ぶ）
+        */
+        void initialize();
+
+        //! A public member function.
+        /*!
+            コマンドを一つ取り出す（サーバーのみが呼ぶ）
+            \param command 取り出したコマンド
+            \return 取り出せたかどうか（キューが空ならfalse）
+        */
+        bool pop(Command & command);
+
+        //! A public member function.
+        /*!
+            コマンドを一つ追加する
+            \param command 追加するコマンド
+            \return 追加できたかどうか（キューが一杯ならfalse）
+        */
+        bool push(Command const & command);
+
+        // #endregion publicメンバ関数
+
+        // #region メンバ変数
+
+        //! A public static member variable (constant expression).
+        /*!
+            キューのスロット数
+        */
+        static auto constexpr CAPACITY = 64U;
+
+        //! A public member variable.
+        /*!
+            次に読み出す位置（サーバーのみが更新する）
+        */
+        std::atomic<std::uint64_t> head;
+
+        //! A public member variable.
+        /*!
+            次に書き込む位置
+        */
+        std::atomic<std::uint64_t> tail;
+
+        //! A public member variable.
+        /*!
+            各スロットの通し番号
+        */
+        std::atomic<std::uint64_t> sequence[CAPACITY];
+
+        //! A public member variable.
+        /*!
+            各スロットのコマンド
+        */
+        Command slots[CAPACITY];
+
+        // #endregion メンバ変数
+    };
+
+    //! A struct.
+    /*!
+        共有メモリ全体の構造
+    */
+    struct SharedState final {
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            共有メモリを初期化する（サーバーのみが呼ぶ）
+            \param ninstances SolveEoMオブジェクトの数
+        */
+        void initialize(std::int32_t ninstances);
+
+        //! A public member function (const).
+        /*!
+            サーバーが初期化を終えた共有メモリかどうかを調べる
+            \return 初期化を終えていればtrue
+        */
+        bool initialized() const;
+
+        // #endregion publicメンバ関数
+
+        // #region メンバ変数
+
+        //! A public static member variable (constant expression).
+        /*!
+            初期化を終えたことを表すマジックナンバー（"SEOM"）
+        */
+        static auto constexpr MAGIC = 0x4D4F4553U;
+
+        //! A public member variable.
+        /*!
+            マジックナンバー（初期化の最後に書き込まれる）
+        */
+        std::atomic<std::uint32_t> magic;
+
+        //! A public member variable.
+        /*!
+            状態を公開するリングバッファ
+        */
+        SharedRing ring;
+
+        //! A public member variable.
+        /*!
+            コマンドを受け付けるキュー
+        */
+        SharedCommandQueue commands;
+
+        //! A public member variable.
+        /*!
+            共有メモリを作成したサーバーのプロセスID（初期化の前に書き込まれる）
+            POSIXでは共有メモリがサーバーの終了後も残るので、残骸かどうかをこれで調べる
+        */
+        std::int64_t serverpid;
+
+        // #endregion メンバ変数
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "プロセス間で共有するにはロックフリーである必要がある");
+
+    // #region メンバ関数の実装
+
+    inline bool Command::valid(std::int32_t ninstances) const
+    {
+        switch (type) {
+        case Command_type::QUIT:
+            return true;
+
+        case Command_type::SETTHETA:
+        case Command_type::SETV:
+        case Command_type::SETRESISTANCE:
+        case Command_type::SETSIMPLEHARMONIC:
+            break;
+
+        case Command_type::SETFLUID:
+            // 空気（0）か水（1）のみ
+            if (value != 0.0 && value != 1.0) {
+                return false;
+            }
+            break;
+
+        default:
+            return false;
+        }
+
+        return instance >= 0 && instance < ninstances && std::isfinite(value);
+    }
+
+    inline void SharedCommandQueue::initialize()
+    {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        for (auto i = 0U; i < SharedCommandQueue::CAPACITY; i++) {
+            sequence[i].store(i, std::memory_order_relaxed);
+        }
+    }
+
+    inline bool SharedCommandQueue::pop(Command & command)
+    {
+        auto const pos = head.load(std::memory_order_relaxed);
+        auto & seq = sequence[pos % SharedCommandQueue::CAPACITY];
+
+        if (seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        command = slots[pos % SharedCommandQueue::CAPACITY];
+        seq.store(pos + SharedCommandQueue::CAPACITY, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    inline bool SharedCommandQueue::push(Command const & command)
+    {
+        auto pos = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto & seq = sequence[pos % SharedCommandQueue::CAPACITY];
+            auto const s = seq.load(std::memory_order_acquire);
+
+            if (s == pos) {
+                // このスロットを確保できれば書き込む
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slots[pos % SharedCommandQueue::CAPACITY] = command;
+                    seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (s < pos) {
+                // 一杯
+                return false;
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    inline void SharedState::initialize(std::int32_t ninstances)
+    {
+        ring.initialize(ninstances);
+        commands.initialize();
+        magic.store(SharedState::MAGIC, std::memory_order_release);
+    }
+
+    inline bool SharedState::initialized() const
+    {
+        return magic.load(std::memory_order_acquire) == SharedState::MAGIC;
+    }
+
+    inline void SharedRing::initialize(std::int32_t ninstances)
+    {
+        this->ninstances = ninstances;
+        head.store(0, std::memory_order_relaxed);
+        for (auto & s : sequence) {
+            s.store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    inline std::uint64_t SharedRing::published() const
+    {
+        return head.load(std::memory_order_acquire);
+    }
+
+    inline bool SharedRing::read(std::uint64_t index, SharedSample & sample) const
+    {
+        auto const n = index % SharedRing::CAPACITY;
+
+        for (auto i = 0U; i < SharedRing::MAXRETRIES; i++) {
+            if (index >= published()) {
+                return false;
+            }
+
+            auto const s1 = sequence[n].load(std::memory_order_acquire);
+            if (s1 & 1U) {
+                // 書き込み中
+                continue;
+            }
+
+            sample = slots[n];
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence[n].load(std::memory_order_relaxed) == s1) {
+                // 周回して上書きされていないか確認する
+                return sample.index == index;
+            }
+        }
+
+        return false;
+    }
+
+    inline void SharedRing::write(SharedSample sample)
+    {
+        auto const index = head.load(std::memory_order_relaxed);
+        auto const n = index % SharedRing::CAPACITY;
+        auto const s = sequence[n].load(std::memory_order_relaxed);
+
+        sequence[n].store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        sample.index = index;
+        slots[n] = sample;
+
+        sequence[n].store(s + 2, std::memory_order_release);
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    // #endregion メンバ関数の実装
+}
+
+#endif  // _SHAREDSTATE_H_
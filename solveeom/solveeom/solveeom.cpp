@@ -5,8 +5,12 @@
     This software is released under the BSD 2-Clause License.
 */
 #include "solveeom.h"
+#include "utility/tracer.h"
+#include <algorithm>                            // for std::any_of
 #include <cmath>                                // for std::sin, std::cos
 #include <fstream>                              // for std::ofstream
+#include <optional>                             // for std::optional
+#include <utility>                              // for std::pair
 #include <boost/assert.hpp>                     // for BOOST_ASSERT
 #include <boost/format.hpp>                     // for boost::format
 #include <boost/math/constants/constants.hpp>   // for boost::math::constants::pi
@@ -28,6 +32,7 @@ namespace solveeom {
 		nyu_(myu_ / rho_),
 		simpleharmonic_(simpleharmonic),
         stepper_(SolveEoM::EPS, SolveEoM::EPS),
+        densestepper_(SolveEoM::EPS, SolveEoM::EPS),
 		x_({ theta0, 0.0 })
     {
     }
@@ -43,6 +48,8 @@ namespace solveeom {
 
     float SolveEoM::operator()(float dt)
     {
+        SOLVEEOM_TRACE_SCOPE("nextstep");
+
         boost::numeric::odeint::integrate_adaptive(
             stepper_,
             getEOM(),
@@ -51,13 +58,20 @@ namespace solveeom {
             static_cast<double>(dt),
             SolveEoM::DX);
 
+        t_ += static_cast<double>(dt);
+
         return static_cast<float>(x_[0]);
     }
 
     void SolveEoM::operator()(double dt, std::string const & filename, double t)
     {
+        SOLVEEOM_TRACE_SCOPE("saveresult");
+
         std::ofstream result(filename);
 
+        // 積分を終えた時刻（最後に出力した時刻）
+        auto end = 0.0;
+
         boost::numeric::odeint::integrate_const(
             stepper_,
             getEOM(),
@@ -65,10 +79,113 @@ namespace solveeom {
             0.0,
             t,
             dt,
-            [&result, this](auto const & x, auto const t)
+            [&result, &end, this](auto const & x, auto const t)
             {
+                SOLVEEOM_TRACE_SCOPE("write");
 				result << boost::format("%.3f, %.15f, %.15f\n") % t % x[0] % total_energy();
+                end = t;
             });
+
+        // 駆動力の位相がoperator()(float)と連続するように、経過時間を進める
+        t_ += end;
+    }
+
+    void SolveEoM::saveresult_decimated(double dt, std::string const & filename, double t, double tol, std::int32_t interpolation)
+    {
+        SOLVEEOM_TRACE_SCOPE("saveresult_decimated");
+
+        using sample_type = std::pair<double, state_type>;
+
+        // 2点の間を補間してθを求める
+        auto const interpolate = [interpolation](sample_type const & s0, sample_type const & s1, double t)
+        {
+            auto const h = s1.first - s0.first;
+            auto const s = (t - s0.first) / h;
+
+            switch (static_cast<SolveEoM::Interpolation_type>(interpolation)) {
+            case SolveEoM::Interpolation_type::LINEAR:
+                return s0.second[0] + s * (s1.second[0] - s0.second[0]);
+
+            case SolveEoM::Interpolation_type::HERMITE:
+            {
+                // dθ/dt = x[1]なので、導関数値は状態から直接得られる
+                auto const h00 = (2.0 * s - 3.0) * s * s + 1.0;
+                auto const h10 = ((s - 2.0) * s + 1.0) * s;
+                auto const h01 = (3.0 - 2.0 * s) * s * s;
+                auto const h11 = (s - 1.0) * s * s;
+
+                return h00 * s0.second[0] + h10 * h * s0.second[1] + h01 * s1.second[0] + h11 * h * s1.second[1];
+            }
+
+            default:
+                BOOST_ASSERT(!"ここに来てはいけない!");
+                return 0.0;
+            }
+        };
+
+        std::ofstream result(filename);
+
+        auto const write = [&result, this](sample_type const & sample)
+        {
+            SOLVEEOM_TRACE_SCOPE("write");
+            result << boost::format("%.6f, %.15f, %.15f, %.15f\n")
+                % sample.first % sample.second[0] % sample.second[1] % total_energy(sample.second);
+        };
+
+        // 最後に出力した点
+        std::optional<sample_type> last;
+
+        // 最後に出力した点より後の、まだ出力していない点
+        std::vector<sample_type> window;
+        window.reserve(SolveEoM::DECIMATIONWINDOW);
+
+        // 積分を終えた時刻
+        auto end = 0.0;
+
+        // 密出力により、時間刻みdtごとの点は補間で求められる
+        boost::numeric::odeint::integrate_const(
+            boost::numeric::odeint::bulirsch_stoer_dense_out<state_type>(SolveEoM::EPS, SolveEoM::EPS),
+            getEOM(),
+            x_,
+            0.0,
+            t,
+            dt,
+            [&](auto const & x, auto const t)
+            {
+                sample_type const sample(t, x);
+                end = t;
+
+                if (!last) {
+                    write(sample);
+                    last = sample;
+                    return;
+                }
+
+                if (!window.empty()) {
+                    auto const exceeded = static_cast<std::int32_t>(window.size()) >= SolveEoM::DECIMATIONWINDOW ||
+                        std::any_of(
+                            window.begin(),
+                            window.end(),
+                            [&](auto const & s) { return std::fabs(interpolate(*last, sample, s.first) - s.second[0]) > tol; });
+
+                    // 直前の点までなら補間で再現できるので、直前の点を出力する
+                    if (exceeded) {
+                        write(window.back());
+                        last = window.back();
+                        window.clear();
+                    }
+                }
+
+                window.push_back(sample);
+            });
+
+        // 最後の点は必ず出力する
+        if (!window.empty()) {
+            write(window.back());
+        }
+
+        // 駆動力の位相がoperator()(float)と連続するように、経過時間を進める
+        t_ += end;
     }
 
     float SolveEoM::potential_energy() const
@@ -76,6 +193,80 @@ namespace solveeom {
         return static_cast<float>(m_ * SolveEoM::g * l_ * (1.0f - std::cos(x_[0])));
     }
 	
+    void SolveEoM::reset(double l, double r, double bobrho, double myu, double rho, double theta0, double v0)
+    {
+        l_ = l;
+        r_ = r;
+        m_ = 4.0 / 3.0 * boost::math::constants::pi<double>() * r * r * r * bobrho;
+        myu_ = myu;
+        rho_ = rho;
+        nyu_ = myu_ / rho_;
+        x_ = { theta0, v0 / l };
+        t_ = 0.0;
+    }
+
+    void SolveEoM::restore(snapshot_type const & snapshot)
+    {
+        l_ = snapshot[0];
+        r_ = snapshot[1];
+        m_ = snapshot[2];
+        myu_ = snapshot[3];
+        rho_ = snapshot[4];
+        nyu_ = myu_ / rho_;
+        resistance_ = snapshot[5] != 0.0;
+        simpleharmonic_ = snapshot[6] != 0.0;
+        driveamplitude_ = snapshot[7];
+        drivefrequency_ = snapshot[8];
+        drivephase_ = snapshot[9];
+        t_ = snapshot[10];
+        x_ = { snapshot[11], snapshot[12] };
+
+        stepper_.reset();
+        densestepper_.reset();
+    }
+
+    std::vector<double> SolveEoM::sensitivity(double dt, std::int32_t n) const
+    {
+        // 感度の初期値（v0 = lω0なので、ω0はv0とlに依存する）
+        sensitivity_state_type x = {};
+        x[0] = x_[0];
+        x[1] = x_[1];
+        x[2] = 1.0;                 // ∂θ/∂θ0
+        x[5] = 1.0 / l_;            // ∂ω/∂v0
+        x[7] = -x_[1] / l_;         // ∂ω/∂l
+
+        std::vector<double> result;
+        if (n <= 0) {
+            return result;
+        }
+
+        result.reserve(static_cast<std::size_t>(n) * (SolveEoM::SENSITIVITYPARAMETERS + 1));
+
+        boost::numeric::odeint::integrate_n_steps(
+            boost::numeric::odeint::bulirsch_stoer_dense_out<sensitivity_state_type>(SolveEoM::EPS, SolveEoM::EPS),
+            getSensitivityEOM(),
+            x,
+            0.0,
+            dt,
+            n - 1,
+            [&result](auto const & x, auto const)
+            {
+                result.push_back(x[0]);
+                for (auto i = 0; i < SolveEoM::SENSITIVITYPARAMETERS; i++) {
+                    result.push_back(x[2 + 2 * i]);
+                }
+            });
+
+        return result;
+    }
+
+    void SolveEoM::setdrive(double amplitude, double frequency, double phase)
+    {
+        driveamplitude_ = amplitude;
+        drivefrequency_ = frequency;
+        drivephase_ = phase;
+    }
+
     void SolveEoM::setfluid(std::int32_t fluid)
     {
         switch (static_cast<SolveEoM::Fluid_type>(fluid)) {
@@ -97,13 +288,92 @@ namespace solveeom {
         nyu_ = myu_ / rho_;
     }
 
+    SolveEoM::snapshot_type SolveEoM::snapshot() const
+    {
+        return {
+            l_, r_, m_, myu_, rho_,
+            resistance_ ? 1.0 : 0.0, simpleharmonic_ ? 1.0 : 0.0,
+            driveamplitude_, drivefrequency_, drivephase_,
+            t_, x_[0], x_[1] };
+    }
+
+    void SolveEoM::solve(std::vector<double> const & times, std::vector<double> & theta)
+    {
+        theta.clear();
+
+        // 密出力のステッパーを使い回して、指定時刻での値は補間で求める
+        boost::numeric::odeint::integrate_times(
+            std::ref(densestepper_),
+            getEOM(),
+            x_,
+            times.begin(),
+            times.end(),
+            SolveEoM::DX,
+            [&theta](auto const & x, auto const) { theta.push_back(x[0]); });
+    }
+
     // #endregion publicメンバ関数
 
     // #region privateメンバ関数
 
+    double SolveEoM::drag_coefficient(double Re)
+    {
+        // N.-S. Cheng, Comparison of formulas for drag coefficient and settling velocity of
+        // spherical particles, Powder Technology 189 (2009) 395–398.
+        if (Re <= 3000) {
+            return 24.0 / Re * std::pow(1.0 + 0.27 * Re, 0.43) + 0.47 * (1.0 - std::exp(-0.04 * std::pow(Re, 0.38)));
+        }
+
+        // Re > 3000
+        // Almedeij J. Drag coefficient of flow around a sphere: Matching asymptotically the wide
+        // trend. std::powder Technology. (2008);doi:10.1016/j.std::powtec.2007.12.006.
+        auto const phi1 = std::pow(24.0 / Re, 10) + std::pow(21.0 * std::pow(Re, -0.67), 10) +
+            std::pow(4.0 * std::pow(Re, -0.33), 10) + std::pow(0.4, 10);
+        auto const phi2 = 1.0 / (1.0 / std::pow(0.148 * std::pow(Re, 0.11), 10) + 1.0 / std::pow(0.5, 10));
+        auto const phi3 = std::pow((1.57E+8) * std::pow(Re, -1.625), 10);
+        auto const phi4 = 1.0 / (1.0 / std::pow((6.0E-17) * std::pow(Re, 2.63), 10) + 1.0 / std::pow(0.2, 10));
+
+        return std::pow((1.0 / (1.0 / (phi1 + phi2) + 1.0 / phi3) + phi4), 0.1);
+    }
+
+    double SolveEoM::drag_coefficient_derivative(double Re)
+    {
+        // drag_coefficient()の各式を解析的に微分したもの
+        if (Re <= 3000) {
+            auto const a = 1.0 + 0.27 * Re;
+            auto const b = std::pow(a, 0.43);
+
+            return -24.0 / (Re * Re) * b + 24.0 / Re * 0.43 * 0.27 * b / a +
+                0.47 * 0.04 * 0.38 * std::pow(Re, -0.62) * std::exp(-0.04 * std::pow(Re, 0.38));
+        }
+
+        auto const p11 = std::pow(24.0 / Re, 10);
+        auto const p12 = std::pow(21.0 * std::pow(Re, -0.67), 10);
+        auto const p13 = std::pow(4.0 * std::pow(Re, -0.33), 10);
+        auto const phi1 = p11 + p12 + p13 + std::pow(0.4, 10);
+        auto const dphi1 = -(10.0 * p11 + 6.7 * p12 + 3.3 * p13) / Re;
+
+        auto const p2 = std::pow(0.148 * std::pow(Re, 0.11), 10);
+        auto const phi2 = 1.0 / (1.0 / p2 + 1.0 / std::pow(0.5, 10));
+        auto const dphi2 = sqr(phi2) * 1.1 / (p2 * Re);
+
+        auto const phi3 = std::pow((1.57E+8) * std::pow(Re, -1.625), 10);
+        auto const dphi3 = -16.25 * phi3 / Re;
+
+        auto const p4 = std::pow((6.0E-17) * std::pow(Re, 2.63), 10);
+        auto const phi4 = 1.0 / (1.0 / p4 + 1.0 / std::pow(0.2, 10));
+        auto const dphi4 = sqr(phi4) * 26.3 / (p4 * Re);
+
+        auto const A = phi1 + phi2;
+        auto const B = 1.0 / (1.0 / A + 1.0 / phi3);
+        auto const dB = sqr(B) * ((dphi1 + dphi2) / sqr(A) + dphi3 / sqr(phi3));
+
+        return 0.1 * std::pow(B + phi4, -0.9) * (dB + dphi4);
+    }
+
 	std::function<void(SolveEoM::state_type const &, SolveEoM::state_type &, double const)> SolveEoM::getEOM() const
     {
-        auto const eom = [this](state_type const & x, state_type & dxdt, double const)
+        auto const eom = [this](state_type const & x, state_type & dxdt, double const t)
         {
             // dθ/dt = v / l
             dxdt[0] = x[1];
@@ -117,6 +387,11 @@ namespace solveeom {
                 f1 = -SolveEoM::g * std::sin(x[0]) / l_;
             }
 
+            // 周期的な駆動力（積分の開始時刻は、これまでに積分した経過時間t_とする）
+            if (driveamplitude_ != 0.0) {
+                f1 += driveamplitude_ * std::cos(drivefrequency_ * (t_ + t) + drivephase_);
+            }
+
             // 空気抵抗を有効にしていなかったら
             if (!resistance_) {
                 dxdt[1] = f1;
@@ -131,37 +406,88 @@ namespace solveeom {
 
             // 粘性抵抗のみ
             if (Re < SolveEoM::THRESHOLD) {
+                SOLVEEOM_TRACE_COUNT("eom_stokes");
                 dxdt[1] = f1 - F / (m_ * l_);
 
                 return;
             }
 
+            SOLVEEOM_TRACE_COUNT("eom_inertial");
             auto const FD = 0.5 * rho_ * boost::math::constants::pi<double>() * sqr(r_ * (l_ * x[1]));
 
             // Drag coefficient
-            double CD;
+            auto const CD = SolveEoM::drag_coefficient(Re);
 
-            // N.-S. Cheng, Comparison of formulas for drag coefficient and settling velocity of
-            // spherical particles, Powder Technology 189 (2009) 395–398.
-            if (Re <= 3000) {
-                CD = 24.0 / Re * std::pow(1.0 + 0.27 * Re, 0.43) + 0.47 * (1.0 - std::exp(-0.04 * std::pow(Re, 0.38)));
+            // 慣性抵抗÷(m×l)
+            auto const f2 = (x[1] >= 0.0) ? -FD * CD / (m_ * l_) : FD * CD / (m_ * l_);
+            dxdt[1] = f1 + f2 - F / (m_ * l_);
+        };
+
+        return eom;
+    }
+
+    std::function<void(SolveEoM::sensitivity_state_type const &, SolveEoM::sensitivity_state_type &, double const)> SolveEoM::getSensitivityEOM() const
+    {
+        auto const eom = [this, f = getEOM()](sensitivity_state_type const & x, sensitivity_state_type & dxdt, double const t)
+        {
+            // 運動方程式そのもの
+            state_type const y = { x[0], x[1] };
+            state_type dydt;
+            f(y, dydt, t);
+            dxdt[0] = dydt[0];
+            dxdt[1] = dydt[1];
+
+            // dω/dtの、θ, ωおよび各パラメータ(θ0, v0, l, r, μ)による偏微分
+            // 駆動力はこれらに依存しないので、偏微分には寄与しない
+            double dfdtheta;
+            double dfdomega = 0.0;
+            std::array<double, SolveEoM::SENSITIVITYPARAMETERS> dfdp = {};
+
+            // 重力の項
+            double f1;
+            if (simpleharmonic_) {
+                f1 = -SolveEoM::g * x[0] / l_;
+                dfdtheta = -SolveEoM::g / l_;
             }
             else {
-                // Re > 3000
-                // Almedeij J. Drag coefficient of flow around a sphere: Matching asymptotically the wide
-                // trend. std::powder Technology. (2008);doi:10.1016/j.std::powtec.2007.12.006.
-                auto const phi1 = std::pow(24.0 / Re, 10) + std::pow(21.0 * std::pow(Re, -0.67), 10) +
-                    std::pow(4.0 * std::pow(Re, -0.33), 10) + std::pow(0.4, 10);
-                auto const phi2 = 1.0 / (1.0 / std::pow(0.148 * std::pow(Re, 0.11), 10) + 1.0 / std::pow(0.5, 10));
-                auto const phi3 = std::pow((1.57E+8) * std::pow(Re, -1.625), 10);
-                auto const phi4 = 1.0 / (1.0 / std::pow((6.0E-17) * std::pow(Re, 2.63), 10) + 1.0 / std::pow(0.2, 10));
-
-                CD = std::pow((1.0 / (1.0 / (phi1 + phi2) + 1.0 / phi3) + phi4), 0.1);
+                f1 = -SolveEoM::g * std::sin(x[0]) / l_;
+                dfdtheta = -SolveEoM::g * std::cos(x[0]) / l_;
             }
+            dfdp[2] = -f1 / l_;
 
-            // 慣性抵抗÷(m×l)
-            auto const f2 = (x[1] >= 0.0) ? -FD * CD / (m_ * l_) : FD * CD / (m_ * l_);
-            dxdt[1] = f1 + f2 - F / (m_ * l_);
+            if (resistance_) {
+                auto const pi = boost::math::constants::pi<double>();
+
+                // 粘性抵抗の項 -6πμrω / m (m ∝ r^3)
+                auto const stokes = -6.0 * pi * myu_ * r_ * x[1] / m_;
+                dfdomega += -6.0 * pi * myu_ * r_ / m_;
+                dfdp[3] += -2.0 * stokes / r_;
+                dfdp[4] += stokes / myu_;
+
+                auto const Re = 2.0 * r_ * std::fabs(l_ * x[1]) / nyu_;
+
+                // 慣性抵抗の項 -sgn(ω)・D・CD(Re)
+                if (Re >= SolveEoM::THRESHOLD) {
+                    auto const sgn = (x[1] >= 0.0) ? 1.0 : -1.0;
+                    auto const D = 0.5 * rho_ * pi * sqr(r_ * (l_ * x[1])) / (m_ * l_);
+                    auto const CD = SolveEoM::drag_coefficient(Re);
+                    auto const dCD = SolveEoM::drag_coefficient_derivative(Re);
+
+                    dfdomega += -sgn * (2.0 * D / x[1] * CD + D * dCD * sgn * 2.0 * r_ * l_ / nyu_);
+                    dfdp[2] += -sgn * (D / l_ * CD + D * dCD * Re / l_);
+                    dfdp[3] += -sgn * (-D / r_ * CD + D * dCD * Re / r_);
+                    dfdp[4] += -sgn * D * dCD * (-Re / myu_);
+                }
+            }
+
+            // 変分方程式 dS/dt = J S + ∂f/∂p
+            for (auto i = 0; i < SolveEoM::SENSITIVITYPARAMETERS; i++) {
+                auto const s0 = x[2 + 2 * i];
+                auto const s1 = x[3 + 2 * i];
+
+                dxdt[2 + 2 * i] = s1;
+                dxdt[3 + 2 * i] = dfdtheta * s0 + dfdomega * s1 + dfdp[i];
+            }
         };
 
         return eom;
@@ -175,5 +501,13 @@ namespace solveeom {
 		return kinetic + potential;
 	}
 
+    double SolveEoM::total_energy(state_type const & x) const
+    {
+        auto const kinetic = 0.5 * m_ * sqr(l_ * x[1]);
+        auto const potential = m_ * SolveEoM::g * l_ * (1.0 - std::cos(x[0]));
+
+        return kinetic + potential;
+    }
+
     // #endregion privateメンバ関数
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <cstdint>						// for std::int32_t
 #include <functional>                   // for std::function
 #include <string>                       // for std::string
+#include <vector>                       // for std::vector
 #include <boost/numeric/odeint.hpp>     // for boost::numeric::odeint
 
 namespace solveeom {
@@ -31,6 +32,24 @@ namespace solveeom {
         単振り子に対して運動方程式を解くクラス
     */
     class SolveEoM final {
+        //! A friend class.
+        /*!
+            保存された軌跡から物理量を求めるクラス
+        */
+        friend class Observables;
+
+        //! A friend class.
+        /*!
+            Parareal法で運動方程式を時間方向に並列に積分するクラス
+        */
+        friend class Parareal;
+
+        //! A friend class.
+        /*!
+            駆動振り子のポアンカレ断面を求めるクラス
+        */
+        friend class PoincareSection;
+
         // #region 列挙型
 
         //!  A enumerated type
@@ -44,6 +63,17 @@ namespace solveeom {
 			WATER = 1
 		};
 
+        //!  A enumerated type
+        /*!
+            間引き出力で用いる補間の種類を表す列挙型
+        */
+        enum class Interpolation_type {
+            // 線形補間
+            LINEAR = 0,
+            // 3次エルミート補間
+            HERMITE = 1
+        };
+
         // #endregion 列挙型
 
         //! A typedef.
@@ -51,6 +81,19 @@ namespace solveeom {
         */
         using state_type = std::array<double, 2>;
 
+        //! A typedef.
+        /*!
+            状態（θ, dθ/dt）と、各パラメータに対するその感度を並べた拡張状態
+        */
+        using sensitivity_state_type = std::array<double, 2 + 2 * 5>;
+
+        //! A typedef.
+        /*!
+            パラメータと状態のすべて（l, r, m, μ, ρ, 空気抵抗の有無, 単振動にするかどうか,
+            駆動力の振幅, 角振動数, 初期位相, 経過時間, θ, dθ/dtの順、bool値は0か1）
+        */
+        using snapshot_type = std::array<double, 13>;
+
         // #region コンストラクタ・デストラクタ
         
     public:
@@ -99,12 +142,67 @@ namespace solveeom {
         */
         void operator()(double dt, std::string const & filename, double t);
 
+        //! A public member function.
+        /*!
+            運動方程式を、指定された時間まで積分し、その結果を間引いてファイルに保存する
+            時間間隔dtごとの点のうち、直前に出力した点からの補間で誤差tolを超える点のみを出力する
+            \param dt 時間刻み
+            \param filename 保存ファイル名
+            \param t 指定時間
+            \param tol θの許容誤差
+            \param interpolation 補間の種類
+        */
+        void saveresult_decimated(double dt, std::string const & filename, double t, double tol, std::int32_t interpolation);
+
         //! A public member function.
         /*!
             ポテンシャルエネルギーを求める
             \return ポテンシャルエネルギー
         */
         float potential_energy() const;
+
+        //! A public member function.
+        /*!
+            パラメータと状態を設定し直す
+            オブジェクトを作り直さずに、別のパラメータで積分をやり直すために用いる
+            \param l ロープの長さ
+            \param r 球の半径
+            \param bobrho 球の密度
+            \param myu 流体の粘度
+            \param rho 流体の密度
+            \param theta0 θの初期値
+            \param v0 速度の初期値
+        */
+        void reset(double l, double r, double bobrho, double myu, double rho, double theta0, double v0);
+
+        //! A public member function.
+        /*!
+            snapshot()で取り出したパラメータと状態を復元する
+            積分法の内部状態（ステップ幅と次数の推定）も初期化されるので、
+            復元した後の積分結果は、同じ値を復元した別のオブジェクトとビット単位で一致する
+            \param snapshot パラメータと状態
+        */
+        void restore(snapshot_type const & snapshot);
+
+        //! A public member function.
+        /*!
+            変分方程式を運動方程式と同時に積分し、θのパラメータ（θ0, v0, l, r, μ）に対する感度を求める
+            現在の状態を初期値とし、現在の状態は変更しない
+            \param dt 時間刻み
+            \param n 求める点の数（時刻0, dt, ..., (n - 1)dt）
+            \return 各時刻について(θ, ∂θ/∂θ0, ∂θ/∂v0, ∂θ/∂l, ∂θ/∂r, ∂θ/∂μ)を並べた配列
+        */
+        std::vector<double> sensitivity(double dt, std::int32_t n) const;
+
+        //! A public member function.
+        /*!
+            周期的な駆動力 amplitude・cos(frequency・t + phase) を角加速度に加える
+            amplitudeが0なら駆動力のない元の運動方程式になる
+            \param amplitude 駆動力の振幅（角加速度, rad/s^2）
+            \param frequency 駆動力の角振動数（rad/s）
+            \param phase 駆動力の初期位相（rad）
+        */
+        void setdrive(double amplitude, double frequency, double phase);
 				
         //! A public member function.
         /*!
@@ -113,6 +211,21 @@ namespace solveeom {
         */
         void setfluid(std::int32_t fluid);
 
+        //! A public member function (const).
+        /*!
+            パラメータと状態のすべてを取り出す
+            \return パラメータと状態
+        */
+        snapshot_type snapshot() const;
+
+        //! A public member function.
+        /*!
+            現在の状態を時刻times[0]での値として運動方程式を積分し、各時刻でのθを求める
+            \param times 時刻の列（昇順）
+            \param theta 各時刻でのθを格納する配列
+        */
+        void solve(std::vector<double> const & times, std::vector<double> & theta);
+
         // #endregion publicメンバ関数
 
     private:
@@ -125,13 +238,44 @@ namespace solveeom {
         */
         std::function<void(state_type const &, state_type &, double const)> getEOM() const;
 
+        //! A private member function.
+        /*!
+            運動方程式と、そのパラメータに対する変分方程式を返す
+            \return 変分方程式のstd::function
+        */
+        std::function<void(sensitivity_state_type const &, sensitivity_state_type &, double const)> getSensitivityEOM() const;
+
 		//! A public member function.
 		/*!
 			全エネルギーを求める
 			\return ポテンシャルエネルギー
 		*/
 		double total_energy() const;
+
+        //! A private member function.
+        /*!
+            与えられた状態に対する全エネルギーを求める
+            \param x 微分方程式の状態
+            \return 全エネルギー
+        */
+        double total_energy(state_type const & x) const;
 		
+        //! A private static member function.
+        /*!
+            球の抗力係数を求める
+            \param Re レイノルズ数
+            \return 抗力係数
+        */
+        static double drag_coefficient(double Re);
+
+        //! A private static member function.
+        /*!
+            球の抗力係数のレイノルズ数による微分を求める
+            \param Re レイノルズ数
+            \return 抗力係数の微分dCD/dRe
+        */
+        static double drag_coefficient_derivative(double Re);
+
         // #endregion privateメンバ関数
 
         // #region プロパティ
@@ -190,6 +334,12 @@ namespace solveeom {
         */
         static auto constexpr DX = 0.01;
 
+        //! A private static member variable (constant expression).
+        /*!
+            間引き出力で、一度に補間する点の最大数
+        */
+        static auto constexpr DECIMATIONWINDOW = 1000;
+
         //! A private static member variable (constant expression).
         /*!
             許容誤差
@@ -202,6 +352,12 @@ namespace solveeom {
         */
         static auto constexpr g = 9.80665;
 
+        //! A private static member variable (constant expression).
+        /*!
+            感度を求めるパラメータの数（θ0, v0, l, r, μ）
+        */
+        static auto constexpr SENSITIVITYPARAMETERS = 5;
+
         //! A private static member variable (constant expression).
         /*!
             レイノルズ数の閾値
@@ -220,6 +376,24 @@ namespace solveeom {
         */
         static auto constexpr WATERRHO = 998.203;
 
+        //! A private member variable.
+        /*!
+            駆動力の振幅（角加速度）
+        */
+        double driveamplitude_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            駆動力の角振動数
+        */
+        double drivefrequency_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            駆動力の初期位相
+        */
+        double drivephase_ = 0.0;
+
         //! A private member variable.
         /*!
             棒の端から球までの長さ
@@ -273,6 +447,18 @@ namespace solveeom {
             Bulirsch-Stoer法のBoost.ODEIntオブジェクト
         */
         boost::numeric::odeint::bulirsch_stoer<state_type> stepper_;
+
+        //! A private member variable.
+        /*!
+            密出力付きBulirsch-Stoer法のBoost.ODEIntオブジェクト
+        */
+        boost::numeric::odeint::bulirsch_stoer_dense_out<state_type> densestepper_;
+
+        //! A private member variable.
+        /*!
+            operator()(float)、operator()(double, ...)、saveresult_decimated()で積分した経過時間（駆動力の位相に用いる）
+        */
+        double t_ = 0.0;
         
         //! A private member variable.
         /*!
@@ -5,65 +5,342 @@
     This software is released under the BSD 2-Clause License.
 */
 #include "solveeommain.h"
+#include "utility/tracer.h"
+#include <algorithm>  // for std::copy
+#include <cstdlib>    // for std::getenv
+#include <exception>  // for std::exception
+#include <tuple>      // for std::tuple_size
+#include <vector>     // for std::vector
+
+namespace {
+    //! A global variable.
+    /*!
+        環境変数SOLVEEOM_RECORDによる自動記録を行うかどうか
+    */
+    bool autorecording = true;
+
+    //! A function (template function).
+    /*!
+        記録中であれば、C APIの呼び出しを記録する
+        \param type 呼び出された関数
+        \param values 引数と戻り値
+    */
+    template <typename... Ts>
+    void record(solveeom::Call_type type, Ts... values)
+    {
+        if (precorder) {
+            (*precorder)(type, values...);
+        }
+    }
+
+    //! A function.
+    /*!
+        記録中であれば、現在の状態をsetsnapshotの呼び出しとして記録する
+        記録しない呼び出しで状態が変わった後や、記録を途中から始めたときに、再生側の状態を揃えるために用いる
+    */
+    void recordstate()
+    {
+        if (precorder && pse) {
+            auto const state = pse->snapshot();
+            setsnapshot(state.data());
+        }
+    }
+}
 
 extern "C" {
+    bool __stdcall attachserver()
+    {
+        try {
+            pshared.emplace(boost::interprocess::open_only);
+            return true;
+        }
+        catch (boost::interprocess::interprocess_exception const &) {
+            pshared.reset();
+            return false;
+        }
+    }
+
+    void __stdcall detachserver()
+    {
+        pshared.reset();
+    }
+
+    bool __stdcall fitparameters(std::string const & filename, bool resistance, bool simpleharmonic, double v0, double r, double bobrho, double const * initials, std::int32_t n, std::int32_t nthreads, double * result)
+    {
+        // フィッティングはseオブジェクトを変更しないので、呼び出しの位置に現在の状態を記録しておけばよい
+        recordstate();
+
+        if (n <= 0) {
+            return false;
+        }
+
+        try {
+            solveeom::ParameterFitting pf(filename, resistance, simpleharmonic, v0, r, bobrho);
+
+            auto constexpr N = std::tuple_size<solveeom::ParameterFitting::parameter_type>::value;
+            std::vector<solveeom::ParameterFitting::parameter_type> starts(n);
+            for (auto i = 0; i < n; i++) {
+                std::copy(initials + N * i, initials + N * (i + 1), starts[i].begin());
+            }
+
+            auto const p = pf(starts, nthreads);
+            std::copy(p.begin(), p.end(), result);
+            result[N] = pf.Residual;
+            result[N + 1] = pf.Condition;
+            result[N + 2] = pf.Elapsed;
+
+            return true;
+        }
+        catch (std::exception const &) {
+            return false;
+        }
+    }
+
+    void __stdcall getsnapshot(double * state)
+    {
+        auto const s = pse->snapshot();
+        std::copy(s.begin(), s.end(), state);
+    }
+
     float __stdcall gettheta()
     {
-        return pse->Theta();
+        auto const theta = pse->Theta();
+        record(solveeom::Call_type::GETTHETA, theta);
+        return theta;
     }
 
     float __stdcall getv()
     {
-        return pse->V();
+        auto const v = pse->V();
+        record(solveeom::Call_type::GETV, v);
+        return v;
     }
 
     void __stdcall init(float l, float r, bool resistance, bool simpleharmonic, float theta0)
     {
+        if (!precorder && autorecording) {
+            // 環境変数で指定されていれば記録を開始する
+            if (auto const filename = std::getenv("SOLVEEOM_RECORD")) {
+                precorder.emplace(filename);
+            }
+        }
+
         pse.emplace(l, r, resistance, simpleharmonic, theta0);
+        record(solveeom::Call_type::INIT, l, r, resistance, simpleharmonic, theta0);
     }
     
     float __stdcall kinetic_energy()
     {
-        return pse->kinetic_energy();
+        auto const kinetic = pse->kinetic_energy();
+        record(solveeom::Call_type::KINETICENERGY, kinetic);
+        return kinetic;
     }
     
     float __stdcall nextstep(float dt)
     {
-        return (*pse)(dt);
+        auto const theta = (*pse)(dt);
+        record(solveeom::Call_type::NEXTSTEP, dt, theta);
+        return theta;
+    }
+
+    void __stdcall observables(double const * theta, double const * omega, std::int32_t n, std::int32_t observables, double * result)
+    {
+        // 負の要素数をstd::size_tに変換すると巨大な値になり、範囲外に書き込んでしまう
+        if (n <= 0) {
+            return;
+        }
+
+        solveeom::Observables const obs(*pse);
+        obs(theta, omega, static_cast<std::size_t>(n), observables, result);
+    }
+
+    bool __stdcall parareal(double t, std::int32_t nslices, double coarsedt, double tol, std::int32_t nthreads, double * result)
+    {
+        try {
+            solveeom::Parareal pr(*pse);
+            auto const x = pr(t, nslices, coarsedt, tol, nthreads);
+
+            result[0] = x[0];
+            result[1] = x[1];
+            result[2] = pr.Iterations;
+            result[3] = pr.Correction;
+            result[4] = pr.Elapsed;
+
+            return true;
+        }
+        catch (std::exception const &) {
+            return false;
+        }
+    }
+
+    bool __stdcall poincaresection(double const * amplitudes, std::int32_t n, std::int64_t transient, std::int64_t periods, std::string const & filename, std::int32_t nthreads, double * elapsed)
+    {
+        if (n <= 0 || transient < 0 || periods <= 0) {
+            return false;
+        }
+
+        try {
+            solveeom::PoincareSection ps(*pse);
+            ps(std::vector<double>(amplitudes, amplitudes + n), transient, periods, filename, nthreads);
+            *elapsed = ps.Elapsed;
+
+            return true;
+        }
+        catch (std::exception const &) {
+            return false;
+        }
     }
 
     float __stdcall potential_energy()
     {
-        return pse->potential_energy();
+        auto const potential = pse->potential_energy();
+        record(solveeom::Call_type::POTENTIALENERGY, potential);
+        return potential;
+    }
+
+    std::uint64_t __stdcall publishedsamples()
+    {
+        return pshared ? (*pshared)->ring.published() : 0;
+    }
+
+    bool __stdcall readlatest(std::int32_t instance, solveeom::SharedSample * sample)
+    {
+        if (!pshared) {
+            return false;
+        }
+
+        // 新しいものから、リングバッファに残っている範囲を遡る
+        auto const & ring = (*pshared)->ring;
+        auto const head = ring.published();
+        auto const oldest = head > solveeom::SharedRing::CAPACITY ? head - solveeom::SharedRing::CAPACITY : 0;
+        for (auto index = head; index > oldest; index--) {
+            solveeom::SharedSample s;
+            if (!ring.read(index - 1, s)) {
+                // 遡る間に上書きされたか、サーバーが書き込みの途中で落ちた
+                return false;
+            }
+
+            if (s.instance == instance) {
+                *sample = s;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool __stdcall readsample(std::uint64_t index, solveeom::SharedSample * sample)
+    {
+        return pshared && (*pshared)->ring.read(index, *sample);
     }
 
     void __stdcall saveresult(double dt, std::string const & filename, double t)
     {
         (*pse)(dt, filename, t);
+        recordstate();
+    }
+
+    void __stdcall saveresult_decimated(double dt, std::string const & filename, double t, double tol, std::int32_t interpolation)
+    {
+        pse->saveresult_decimated(dt, filename, t, tol, interpolation);
+        recordstate();
+    }
+
+    void __stdcall savetrace(char const * filename)
+    {
+        utility::Tracer::save(filename);
+    }
+
+    bool __stdcall sendcommand(std::int32_t type, std::int32_t instance, double value)
+    {
+        if (!pshared) {
+            return false;
+        }
+
+        solveeom::Command const command = { static_cast<solveeom::Command_type>(type), instance, value };
+        return command.valid((*pshared)->ring.ninstances) && (*pshared)->commands.push(command);
+    }
+
+    void __stdcall sensitivity(double dt, std::int32_t n, double * result)
+    {
+        auto const s = pse->sensitivity(dt, n);
+        std::copy(s.begin(), s.end(), result);
+    }
+
+    std::int32_t __stdcall serverinstances()
+    {
+        return pshared ? (*pshared)->ring.ninstances : 0;
+    }
+
+    void __stdcall setautorecording(bool enable)
+    {
+        autorecording = enable;
+    }
+
+    void __stdcall setdrive(double amplitude, double frequency, double phase)
+    {
+        pse->setdrive(amplitude, frequency, phase);
+        record(solveeom::Call_type::SETDRIVE, amplitude, frequency, phase);
     }
 
     void __stdcall setfluid(std::int32_t fluid)
     {
         pse->setfluid(fluid);
+        record(solveeom::Call_type::SETFLUID, fluid);
     }
 
     void __stdcall setresistance(bool resistance)
     {
         pse->Resistance(resistance);
+        record(solveeom::Call_type::SETRESISTANCE, resistance);
     }
 
     void __stdcall setsimpleharmonic(bool simpleharmonic)
     {
         pse->Simpleharmonic(simpleharmonic);
+        record(solveeom::Call_type::SETSIMPLEHARMONIC, simpleharmonic);
+    }
+
+    void __stdcall setsnapshot(double const * state)
+    {
+        auto s = pse->snapshot();
+        std::copy(state, state + s.size(), s.begin());
+        pse->restore(s);
+        record(solveeom::Call_type::SETSNAPSHOT, s);
     }
 
     void __stdcall settheta(float theta)
     {
         pse->Theta(theta);
+        record(solveeom::Call_type::SETTHETA, theta);
     }
 
     void __stdcall setv(float v)
     {
         pse->V(v);
+        record(solveeom::Call_type::SETV, v);
+    }
+
+    void __stdcall startrecording(char const * filename)
+    {
+        precorder.emplace(filename);
+
+        if (pse) {
+            // 再生側でseオブジェクトを作るinitと、現在の状態に揃えるsetsnapshotを先頭に記録する
+            auto const state = pse->snapshot();
+            record(
+                solveeom::Call_type::INIT,
+                static_cast<float>(state[0]),
+                static_cast<float>(state[1]),
+                state[5] != 0.0,
+                state[6] != 0.0,
+                static_cast<float>(state[11]));
+            recordstate();
+        }
+    }
+
+    void __stdcall stoprecording()
+    {
+        precorder.reset();
     }
 }
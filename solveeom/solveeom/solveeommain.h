@@ -13,6 +13,12 @@
 #define DLLEXPORT __declspec(dllexport)
 #endif
 
+#include "callrecorder.h"
+#include "observables.h"
+#include "parameterfitting.h"
+#include "parareal.h"
+#include "poincaresection.h"
+#include "sharedmemory.h"
 #include "solveeom.h"
 #include <optional>		// for std::optional
 
@@ -22,7 +28,40 @@ extern "C" {
         SolveEoMクラスのオブジェクトへのポインタ
     */
     static std::optional<solveeom::SolveEoM> pse;
+
+    //! A global variable.
+    /*!
+        C APIの呼び出しを記録するオブジェクト（記録しないときは空）
+    */
+    static std::optional<solveeom::CallRecorder> precorder;
+
+    //! A global variable.
+    /*!
+        接続しているシミュレーションサーバーの共有メモリ（接続していないときは空）
+    */
+    static std::optional<solveeom::SharedMemory> pshared;
+
+    //! A global function.
+    /*!
+        動作中のシミュレーションサーバー（solveeomserver）の共有メモリに接続する
+        \return 接続できたかどうか（サーバーが動いていなければfalse）
+    */
+    DLLEXPORT bool __stdcall attachserver();
+
+    //! A global function.
+    /*!
+        シミュレーションサーバーの共有メモリから切断する
+    */
+    DLLEXPORT void __stdcall detachserver();
     
+    //! A global function.
+    /*!
+        パラメータと状態のすべてを取り出す
+        \param state 結果を格納する、要素数13の配列（l, r, m, μ, ρ, 空気抵抗の有無, 単振動にするかどうか,
+            駆動力の振幅, 角振動数, 初期位相, 経過時間, θ, dθ/dtの順、bool値は0か1）
+    */
+    DLLEXPORT void __stdcall getsnapshot(double * state);
+
     //! A global function.
     /*!
         角度θの値に対するgetter
@@ -37,6 +76,24 @@ extern "C" {
     */
     DLLEXPORT float __stdcall getv();
 
+    //! A global function.
+    /*!
+        測定された軌跡(t, θ)に、ロープの長さ・流体の粘度・流体の密度をフィッティングする
+        運動方程式はl, μ/(r^2・ρ_bob), ρ/(r・ρ_bob)にしか依存しないので、球の半径と密度は測定値として与える
+        \param filename 測定データのファイル名
+        \param resistance 空気抵抗の有無
+        \param simpleharmonic 単振動にするかどうか
+        \param v0 速度の初期値
+        \param r 球の半径（測定値）
+        \param bobrho 球の密度（測定値）
+        \param initials パラメータの初期値を並べた、要素数3nの配列（l, 粘度, 流体の密度の順）
+        \param n 初期値の数
+        \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+        \param result 結果を格納する、要素数6の配列（フィッティングされた3つのパラメータ, 残差二乗和, J^T Jの条件数, 経過時間（秒）の順）
+        \return フィッティングに成功したかどうか
+    */
+    DLLEXPORT bool __stdcall fitparameters(std::string const & filename, bool resistance, bool simpleharmonic, double v0, double r, double bobrho, double const * initials, std::int32_t n, std::int32_t nthreads, double * result);
+
     //! A global function.
     /*!
         seオブジェクトを初期化する
@@ -63,6 +120,48 @@ extern "C" {
     */
     DLLEXPORT float __stdcall nextstep(float dt);
 
+    //! A global function.
+    /*!
+        保存された軌跡(θ, dθ/dt)から、指定された物理量を一度の走査でまとめて求める
+        振り子と流体のパラメータは、現在のseオブジェクトのものを用いる
+        \param theta θの配列
+        \param omega dθ/dtの配列
+        \param n 配列の要素数（0以下なら何もしない）
+        \param observables 求める物理量のビットの論理和（1: 運動エネルギー, 2: ポテンシャルエネルギー, 4: 全エネルギー,
+            8: レイノルズ数, 16: 粘性抵抗, 32: 抗力係数, 64: 散逸する仕事率）
+        \param result 結果を格納する、要素数n×(指定した物理量の数)の配列（物理量ごとに、ビットの小さい順に並ぶ）
+    */
+    DLLEXPORT void __stdcall observables(double const * theta, double const * omega, std::int32_t n, std::int32_t observables, double * result);
+
+    //! A global function.
+    /*!
+        Parareal法で、運動方程式を時刻tまで時間方向に並列に積分する
+        現在の状態を初期値とし、現在の状態は変更しない
+        \param t 指定時間
+        \param nslices スライスの数
+        \param coarsedt 粗い解法（4次Runge-Kutta法）の時間刻み
+        \param tol 反復の収束判定の許容誤差（スライス境界での状態の修正量の最大値）
+        \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+        \param result 結果を格納する、要素数5の配列（θ, dθ/dt, 反復回数, 最後の修正量, 経過時間（秒）の順）
+        \return 積分に成功したかどうか（引数が正しくないか、積分に失敗したときはfalseで、resultは変更しない）
+    */
+    DLLEXPORT bool __stdcall parareal(double t, std::int32_t nslices, double coarsedt, double tol, std::int32_t nthreads, double * result);
+
+    //! A global function.
+    /*!
+        駆動力の各振幅について、駆動力の一周期ごとの状態（ポアンカレ断面）を求め、バイナリ形式でファイルに保存する
+        振り子と流体のパラメータ、初期状態、駆動力の角振動数と位相は、現在のseオブジェクトのものを用いる（位相は現在の時刻でのもの）
+        \param amplitudes 駆動力の振幅の配列
+        \param n 振幅の数（正であること）
+        \param transient 捨てる過渡状態の周期の数（0以上であること）
+        \param periods 保存する周期の数（正であること）
+        \param filename 保存ファイル名
+        \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+        \param elapsed 経過時間（秒）を格納する変数
+        \return 保存に成功したかどうか
+    */
+    DLLEXPORT bool __stdcall poincaresection(double const * amplitudes, std::int32_t n, std::int64_t transient, std::int64_t periods, std::string const & filename, std::int32_t nthreads, double * elapsed);
+
     //! A global function.
     /*!
         ポテンシャルエネルギーを求める
@@ -70,6 +169,31 @@ extern "C" {
     */
     DLLEXPORT float __stdcall potential_energy();
 
+    //! A global function.
+    /*!
+        シミュレーションサーバーがこれまでに公開した状態の数を返す
+        \return 公開された状態の数（接続していなければ0）
+    */
+    DLLEXPORT std::uint64_t __stdcall publishedsamples();
+
+    //! A global function.
+    /*!
+        シミュレーションサーバーが公開した、指定されたSolveEoMオブジェクトの最新の状態を読み出す
+        \param instance SolveEoMオブジェクトの番号
+        \param sample 読み出した状態を格納する変数
+        \return 読み出せたかどうか（接続していないか、リングバッファに残っていなければfalse）
+    */
+    DLLEXPORT bool __stdcall readlatest(std::int32_t instance, solveeom::SharedSample * sample);
+
+    //! A global function.
+    /*!
+        シミュレーションサーバーが公開した、通し番号indexの状態を読み出す
+        \param index 通し番号
+        \param sample 読み出した状態を格納する変数
+        \return 読み出せたかどうか（接続していないか、まだ公開されていないか、既に上書きされているか、書き込み中のままであればfalse）
+    */
+    DLLEXPORT bool __stdcall readsample(std::uint64_t index, solveeom::SharedSample * sample);
+
     //! A global function.
     /*!
         運動方程式を、指定された時間まで積分し、その結果を時間間隔Δtごとにファイルに保存する
@@ -79,6 +203,60 @@ extern "C" {
     */
     DLLEXPORT void __stdcall saveresult(double dt, std::string const & filename, double t);
 
+    //! A global function.
+    /*!
+        運動方程式を、指定された時間まで積分し、その結果を誤差tol以内で再現できるよう間引いてファイルに保存する
+        \param dt 時間刻み
+        \param filename 保存ファイル名
+        \param t 指定時間
+        \param tol θの許容誤差
+        \param interpolation 補間の種類（0: 線形補間、1: 3次エルミート補間）
+    */
+    DLLEXPORT void __stdcall saveresult_decimated(double dt, std::string const & filename, double t, double tol, std::int32_t interpolation);
+
+    //! A global function.
+    /*!
+        記録された処理区間と、運動方程式の右辺で通った抵抗の分岐の回数を、Chrome/Perfettoで読めるトレース形式（JSON）で保存する
+        スレッドごとに最新の2^18個のみが残る（古いものから上書きされる）
+        記録されるのは、SOLVEEOM_TRACEを定義してビルドしたときのみ
+        \param filename 保存ファイル名
+    */
+    DLLEXPORT void __stdcall savetrace(char const * filename);
+
+    //! A global function.
+    /*!
+        シミュレーションサーバーにコマンドを送る
+        \param type コマンドの種類（solveeom::Command_typeの値）
+        \param instance 対象のSolveEoMオブジェクトの番号
+        \param value 設定する値（bool値は0か1、流体の種類はsetfluidの引数）
+        \return 送れたかどうか（接続していないか、コマンドが正しくないか、キューが一杯ならfalse）
+    */
+    DLLEXPORT bool __stdcall sendcommand(std::int32_t type, std::int32_t instance, double value);
+
+    //! A global function.
+    /*!
+        θのパラメータ（θ0, v0, l, r, μ）に対する感度を、変分方程式を同時に積分して求める
+        \param dt 時間刻み
+        \param n 求める点の数
+        \param result 結果を格納する、要素数6nの配列（各時刻について θ, ∂θ/∂θ0, ∂θ/∂v0, ∂θ/∂l, ∂θ/∂r, ∂θ/∂μ の順）
+    */
+    DLLEXPORT void __stdcall sensitivity(double dt, std::int32_t n, double * result);
+
+    //! A global function.
+    /*!
+        シミュレーションサーバーのSolveEoMオブジェクトの数を返す
+        \return SolveEoMオブジェクトの数（接続していなければ0）
+    */
+    DLLEXPORT std::int32_t __stdcall serverinstances();
+
+    //! A global function.
+    /*!
+        環境変数SOLVEEOM_RECORDによる自動記録を行うかどうかを設定する
+        記録を再生するときは、再生中のinitで記録ファイルを上書きしないよう、最初のinitより前に無効にする
+        \param enable 自動記録を行うかどうか
+    */
+    DLLEXPORT void __stdcall setautorecording(bool enable);
+
     //! A global function.
     /*!
         流体の種類を切り替える
@@ -86,6 +264,15 @@ extern "C" {
     */
     DLLEXPORT void __stdcall setfluid(std::int32_t fluid);
 
+    //! A global function.
+    /*!
+        周期的な駆動力 amplitude・cos(frequency・t + phase) を角加速度に加える
+        \param amplitude 駆動力の振幅（角加速度, rad/s^2）
+        \param frequency 駆動力の角振動数（rad/s）
+        \param phase 駆動力の初期位相（rad）
+    */
+    DLLEXPORT void __stdcall setdrive(double amplitude, double frequency, double phase);
+
     //! A global function.
     /*!
         空気抵抗の有無に対するsetter
@@ -100,6 +287,13 @@ extern "C" {
     */
     DLLEXPORT void __stdcall setsimpleharmonic(bool simpleharmonic);
 
+    //! A global function.
+    /*!
+        getsnapshotで取り出したパラメータと状態を復元する
+        \param state パラメータと状態を格納した、要素数13の配列（getsnapshotと同じ順）
+    */
+    DLLEXPORT void __stdcall setsnapshot(double const * state);
+
     //! A global function.
     /*!
         角度θの値に対するsetter
@@ -113,6 +307,23 @@ extern "C" {
         \return 設定する速度v
     */
     DLLEXPORT void __stdcall setv(float v);
+
+    //! A global function.
+    /*!
+        C APIの呼び出しの記録を開始する
+        init, nextstep, get*, set*, kinetic_energy, potential_energyの呼び出しと、その引数・戻り値が記録される
+        initの後に開始したときは、再生できるように、現在の状態を表すinitとsetsnapshotの呼び出しが最初に記録される
+        saveresult, saveresult_decimated, fitparametersの呼び出しは、その後の状態を表すsetsnapshotの呼び出しとして記録される
+        環境変数SOLVEEOM_RECORDにファイル名を設定しておくと、最初のinitの呼び出し時に自動で記録を開始する（setautorecordingで無効にできる）
+        \param filename 記録ファイル名
+    */
+    DLLEXPORT void __stdcall startrecording(char const * filename);
+
+    //! A global function.
+    /*!
+        C APIの呼び出しの記録を終了する
+    */
+    DLLEXPORT void __stdcall stoprecording();
 }
 
 #endif  // _SOLVEEOMMAIN_H_
@@ -0,0 +1,120 @@
+﻿/*! \file tracer.cpp
+    \brief 処理区間の開始・終了時刻を記録し、Chromeのトレース形式で出力するクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "tracer.h"
+#include <algorithm>                // for std::max
+#include <fstream>                  // for std::ofstream
+#include <boost/format.hpp>         // for boost::format
+
+namespace utility {
+    // #region staticメンバ変数の定義
+
+    std::vector<std::shared_ptr<Tracer::Buffer>> Tracer::buffers_;
+
+    std::vector<Tracer::Buffer *> Tracer::free_;
+
+    std::mutex Tracer::mutex_;
+
+    // #endregion staticメンバ変数の定義
+
+    // #region publicメンバ関数
+
+    void Tracer::save(std::string const & filename)
+    {
+        std::ofstream ofs(filename);
+        ofs << "{\"traceEvents\":[";
+
+        auto first = true;
+        std::lock_guard<std::mutex> lock(Tracer::mutex_);
+
+        for (auto const & buf : Tracer::buffers_) {
+            // countをacquireで読めば、そこまでの区間は書き込み済みである
+            auto const n = buf->count.load(std::memory_order_acquire);
+            auto const oldest = n > Tracer::CAPACITY ? n - Tracer::CAPACITY : 0;
+
+            std::vector<Event> events;
+            events.reserve(n - oldest);
+            for (auto i = oldest; i < n; i++) {
+                events.push_back(buf->events[i % Tracer::CAPACITY]);
+            }
+
+            // 読んでいる間に記録を続けるスレッドもあるので、その間に上書きされたかもしれない古いものは捨てる
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto const now = buf->count.load(std::memory_order_relaxed);
+            auto const valid = std::max(oldest, now > Tracer::CAPACITY ? now - Tracer::CAPACITY : 0);
+
+            if (valid) {
+                ofs << (first ? "\n" : ",\n")
+                    << boost::format("{\"name\":\"overwritten %d events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}")
+                    % valid % buf->tid % (valid < n ? events[valid - oldest].begin * 1.0E-3 : 0.0);
+                first = false;
+            }
+
+            for (auto i = valid; i < n; i++) {
+                auto const & e = events[i - oldest];
+
+                ofs << (first ? "\n" : ",\n");
+                switch (e.type) {
+                case Event_type::SPAN:
+                    ofs << boost::format("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}")
+                        % e.name % buf->tid % (e.begin * 1.0E-3) % ((e.end - e.begin) * 1.0E-3);
+                    break;
+
+                case Event_type::COUNTER:
+                    // Chromeのカウンタはプロセス単位なので、名前にスレッドの番号を付ける
+                    ofs << boost::format("{\"name\":\"%s (tid %d)\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"count\":%d}}")
+                        % e.name % buf->tid % (e.begin * 1.0E-3) % e.end;
+                    break;
+                }
+                first = false;
+            }
+        }
+
+        ofs << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    Tracer::Buffer & Tracer::buffer()
+    {
+        // スレッドが終了するときに、使っていたバッファを返す
+        // （ParameterFittingなどは呼び出しごとにスレッドを作るので、返さないとバッファが増え続ける）
+        struct Lease final {
+            Buffer * buf = nullptr;
+
+            ~Lease()
+            {
+                if (buf) {
+                    std::lock_guard<std::mutex> lock(Tracer::mutex_);
+                    Tracer::free_.push_back(buf);
+                }
+            }
+        };
+
+        thread_local Lease lease;
+
+        if (!lease.buf) {
+            std::lock_guard<std::mutex> lock(Tracer::mutex_);
+
+            if (!Tracer::free_.empty()) {
+                lease.buf = Tracer::free_.back();
+                Tracer::free_.pop_back();
+            }
+            else {
+                auto const p = std::make_shared<Buffer>();
+                p->tid = static_cast<std::uint32_t>(Tracer::buffers_.size() + 1);
+                Tracer::buffers_.push_back(p);
+                lease.buf = p.get();
+            }
+        }
+
+        return *lease.buf;
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,399 @@
+﻿/*! \file tracer.h
+    \brief 処理区間の開始・終了時刻を記録し、Chromeのトレース形式で出力するクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _TRACER_H_
+#define _TRACER_H_
+
+#pragma once
+
+#include <array>        // for std::array
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for std::int64_t, std::uint32_t
+#include <memory>       // for std::shared_ptr
+#include <mutex>        // for std::mutex
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+
+//! A macro.
+/*!
+    SOLVEEOM_TRACEが定義されているときのみ、SOLVEEOM_TRACE_SCOPEはそのスコープの開始から終了までを区間として記録し、
+    SOLVEEOM_TRACE_COUNTは名前付きのカウンタを1増やす
+    定義されていなければ何も生成されない
+*/
+#ifdef SOLVEEOM_TRACE
+#define SOLVEEOM_TRACE_CONCAT_IMPL(a, b) a##b
+#define SOLVEEOM_TRACE_CONCAT(a, b) SOLVEEOM_TRACE_CONCAT_IMPL(a, b)
+#define SOLVEEOM_TRACE_SCOPE(name) utility::TraceScope const SOLVEEOM_TRACE_CONCAT(tracescope_, __LINE__)(name)
+#define SOLVEEOM_TRACE_COUNT(name) utility::Tracer::count(name)
+#else
+#define SOLVEEOM_TRACE_SCOPE(name)
+#define SOLVEEOM_TRACE_COUNT(name)
+#endif
+
+namespace utility {
+    //! A class.
+    /*!
+        処理区間とカウンタを記録し、Chrome/Perfettoで読めるJSON形式で出力するクラス
+        区間はスレッドごとの固定長のリングバッファに書かれ（一杯なら最も古いものから上書きする）、記録時にロックは取らない
+        リングバッファは区間を初めて記録したときに割り当て、スレッドが終了したら別のスレッドに使い回す
+        カウンタはスレッドごとの小さな配列で数えるだけなので、運動方程式の右辺のように非常に頻繁に通る箇所にはこちらを用いる
+    */
+    class Tracer final {
+        // #region publicメンバ関数
+
+    public:
+        //! A public static member function.
+        /*!
+            呼び出したスレッドの名前付きのカウンタを1増やす
+            カウンタの値は、次に区間が記録されたときに（変化していれば）その終了時刻での値として記録される
+            \param name カウンタの名前（文字列リテラルであること）
+        */
+        static void count(char const * name);
+
+        //! A public static member function.
+        /*!
+            現在の時刻を返す
+            \return std::chrono::steady_clockのナノ秒
+        */
+        static std::int64_t now();
+
+        //! A public static member function.
+        /*!
+            呼び出したスレッドのバッファに区間を一つ記録する
+            バッファが一杯なら最も古いものを上書きする
+            \param name 区間の名前（文字列リテラルであること）
+            \param begin 開始時刻（ナノ秒）
+            \param end 終了時刻（ナノ秒）
+        */
+        static void record(char const * name, std::int64_t begin, std::int64_t end);
+
+        //! A public static member function.
+        /*!
+            バッファに残っている区間とカウンタの値を、Chromeのトレース形式（JSON）でファイルに保存する
+            \param filename 保存ファイル名
+        */
+        static void save(std::string const & filename);
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region 型
+
+        //! A private static member variable (constant expression).
+        /*!
+            スレッドごとのバッファに記録できる区間の数
+        */
+        static auto constexpr CAPACITY = 1U << 18;
+
+        //! A private static member variable (constant expression).
+        /*!
+            スレッドごとのカウンタの数の上限（超えた分は数えない）
+        */
+        static auto constexpr MAXCOUNTERS = 8U;
+
+        //!  A enumerated type
+        /*!
+            記録されたものの種類を表す列挙型
+        */
+        enum class Event_type {
+            // 区間
+            SPAN = 0,
+            // カウンタの値
+            COUNTER = 1
+        };
+
+        //! A struct.
+        /*!
+            一つの区間、またはある時刻でのカウンタの値
+        */
+        struct Event final {
+            //! A public member variable.
+            /*!
+                種類
+            */
+            Event_type type;
+
+            //! A public member variable.
+            /*!
+                区間またはカウンタの名前
+            */
+            char const * name;
+
+            //! A public member variable.
+            /*!
+                開始時刻（カウンタなら記録した時刻）（ナノ秒）
+            */
+            std::int64_t begin;
+
+            //! A public member variable.
+            /*!
+                終了時刻（ナノ秒）（カウンタなら値）
+            */
+            std::int64_t end;
+        };
+
+        //! A struct.
+        /*!
+            一つのカウンタ
+        */
+        struct Counter final {
+            //! A public member variable.
+            /*!
+                カウンタの名前
+            */
+            char const * name;
+
+            //! A public member variable.
+            /*!
+                現在の値
+            */
+            std::int64_t value;
+
+            //! A public member variable.
+            /*!
+                最後にバッファに記録した値
+            */
+            std::int64_t recorded;
+        };
+
+        //! A struct.
+        /*!
+            スレッドごとのカウンタ（thread_localに置き、リングバッファは割り当てない）
+        */
+        struct Counters final {
+            //! A public member variable.
+            /*!
+                カウンタ
+            */
+            std::array<Counter, Tracer::MAXCOUNTERS> counters;
+
+            //! A public member variable.
+            /*!
+                カウンタの数
+            */
+            std::uint32_t ncounters = 0;
+        };
+
+        //! A struct.
+        /*!
+            スレッドごとのバッファ
+            書き込むのは使用中のスレッドのみで、countをreleaseで更新してから読み出し側に見せる
+        */
+        struct Buffer final {
+            //! A public member variable.
+            /*!
+                スレッドの番号
+            */
+            std::uint32_t tid;
+
+            //! A public member variable.
+            /*!
+                これまでに記録された区間とカウンタの値の数（上書きされたものも含む）
+            */
+            std::atomic<std::size_t> count{ 0 };
+
+            //! A public member variable.
+            /*!
+                記録された区間とカウンタの値（count % CAPACITY番目に書く）
+            */
+            std::array<Event, Tracer::CAPACITY> events;
+        };
+
+        // #endregion 型
+
+        // #region privateメンバ関数
+
+        //! A private static member function.
+        /*!
+            呼び出したスレッドのバッファを返す
+            初回は、終了したスレッドが返したバッファがあればそれを、なければ新しく作成して登録したものを用いる
+            \return 呼び出したスレッドのバッファ
+        */
+        static Buffer & buffer();
+
+        //! A private static member function.
+        /*!
+            呼び出したスレッドのカウンタを返す
+            \return 呼び出したスレッドのカウンタ
+        */
+        static Counters & counters();
+
+        //! A private static member function.
+        /*!
+            バッファの次の位置に書き込む（一杯なら最も古いものを上書きする）
+            \param buf 書き込むバッファ
+            \param event 書き込むもの
+        */
+        static void push(Buffer & buf, Event const & event);
+
+        // #endregion privateメンバ関数
+
+        // #region メンバ変数
+
+        //! A private static member variable.
+        /*!
+            すべてのスレッドのバッファ（スレッドの終了後も出力できるよう保持する）
+        */
+        static std::vector<std::shared_ptr<Buffer>> buffers_;
+
+        //! A private static member variable.
+        /*!
+            終了したスレッドが返した、使い回せるバッファ
+        */
+        static std::vector<Buffer *> free_;
+
+        //! A private static member variable.
+        /*!
+            buffers_とfree_を保護するミューテックス（バッファの取得・返却と出力のときのみ用いる）
+        */
+        static std::mutex mutex_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        Tracer() = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+
+    //! A class.
+    /*!
+        生成から破棄までを一つの区間としてTracerに記録するクラス
+    */
+    class TraceScope final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param name 区間の名前（文字列リテラルであること）
+        */
+        explicit TraceScope(char const * name) :
+            name_(name), begin_(Tracer::now())
+        {
+        }
+
+        //! A destructor.
+        /*!
+            区間を記録する
+        */
+        ~TraceScope()
+        {
+            Tracer::record(name_, begin_, Tracer::now());
+        }
+
+        // #endregion コンストラクタ・デストラクタ
+
+    private:
+        // #region メンバ変数
+
+        //! A private member variable.
+        /*!
+            区間の名前
+        */
+        char const * const name_;
+
+        //! A private member variable.
+        /*!
+            開始時刻（ナノ秒）
+        */
+        std::int64_t const begin_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        TraceScope() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        TraceScope(TraceScope const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        TraceScope & operator=(TraceScope const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+
+    // #region インライン関数の実装
+
+    inline std::int64_t Tracer::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline void Tracer::count(char const * name)
+    {
+        auto & c = Tracer::counters();
+
+        // 名前は文字列リテラルなので、ポインタで比較すればよい
+        for (auto i = 0U; i < c.ncounters; i++) {
+            if (c.counters[i].name == name) {
+                c.counters[i].value++;
+                return;
+            }
+        }
+
+        if (c.ncounters < Tracer::MAXCOUNTERS) {
+            c.counters[c.ncounters++] = { name, 1, 0 };
+        }
+    }
+
+    inline Tracer::Counters & Tracer::counters()
+    {
+        thread_local Counters c;
+        return c;
+    }
+
+    inline void Tracer::push(Buffer & buf, Event const & event)
+    {
+        auto const n = buf.count.load(std::memory_order_relaxed);
+
+        buf.events[n % Tracer::CAPACITY] = event;
+        buf.count.store(n + 1, std::memory_order_release);
+    }
+
+    inline void Tracer::record(char const * name, std::int64_t begin, std::int64_t end)
+    {
+        auto & buf = Tracer::buffer();
+        Tracer::push(buf, { Event_type::SPAN, name, begin, end });
+
+        // 変化したカウンタの値を、区間の終了時刻での値として記録する
+        auto & counters = Tracer::counters();
+        for (auto i = 0U; i < counters.ncounters; i++) {
+            auto & c = counters.counters[i];
+            if (c.value != c.recorded) {
+                Tracer::push(buf, { Event_type::COUNTER, c.name, end, c.value });
+                c.recorded = c.value;
+            }
+        }
+    }
+
+    // #endregion インライン関数の実装
+}
+
+#endif  // _TRACER_H_
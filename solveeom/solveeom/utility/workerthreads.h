@@ -0,0 +1,86 @@
+﻿/*! \file workerthreads.h
+    \brief 同じ処理を複数のスレッドで実行し、その終了を待つ関数の宣言と実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _WORKERTHREADS_H_
+#define _WORKERTHREADS_H_
+
+#pragma once
+
+#include <algorithm>    // for std::max
+#include <cstdint>      // for std::int32_t
+#include <exception>    // for std::current_exception, std::exception_ptr, std::rethrow_exception
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+namespace utility {
+    //! A function.
+    /*!
+        実際に用いるスレッド数を返す
+        \param nthreads 指定されたスレッド数（0以下ならハードウェアのスレッド数）
+        \return スレッド数
+    */
+    inline std::int32_t threadcount(std::int32_t nthreads)
+    {
+        if (nthreads > 0) {
+            return nthreads;
+        }
+
+        return static_cast<std::int32_t>(std::max(std::thread::hardware_concurrency(), 1U));
+    }
+
+    //! A function (template function).
+    /*!
+        workerをnthreads個のスレッドで同時に実行し、すべてが終わるまで待つ
+        スレッドの外に例外を投げるとstd::terminateが呼ばれるので、各スレッドで捕まえておき、
+        すべてのスレッドが終わった後で最初のものを投げ直す
+        \param nthreads スレッド数（0以下ならハードウェアのスレッド数）
+        \param worker 各スレッドで実行する関数オブジェクト
+    */
+    template <typename F>
+    void runthreads(std::int32_t nthreads, F const & worker)
+    {
+        nthreads = threadcount(nthreads);
+
+        std::vector<std::exception_ptr> errors(nthreads);
+        std::vector<std::thread> threads;
+        threads.reserve(nthreads);
+
+        try {
+            for (auto i = 0; i < nthreads; i++) {
+                threads.emplace_back([&worker, &error = errors[i]]
+                {
+                    try {
+                        worker();
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                });
+            }
+        }
+        catch (...) {
+            // スレッドを作れなかったときも、作れたスレッドは待ってから投げる
+            for (auto & th : threads) {
+                th.join();
+            }
+
+            throw;
+        }
+
+        for (auto & th : threads) {
+            th.join();
+        }
+
+        for (auto const & e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+    }
+}
+
+#endif  // _WORKERTHREADS_H_
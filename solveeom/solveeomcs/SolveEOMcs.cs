@@ -9,6 +9,57 @@ namespace Solveeomcs
     using System;
     using System.Runtime.InteropServices;
 
+    /// <summary>
+    /// シミュレーションサーバーが共有メモリに公開する、ある時刻での一つの振り子の状態（C++のsolveeom::SharedSampleと同じレイアウト）
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SharedSample
+    {
+        #region フィールド
+
+        /// <summary>
+        /// 公開された順の通し番号
+        /// </summary>
+        public UInt64 Index;
+
+        /// <summary>
+        /// 公開した時刻（サーバーのstd::chrono::steady_clockのナノ秒）
+        /// </summary>
+        public Int64 Timestamp;
+
+        /// <summary>
+        /// シミュレーション内の時刻
+        /// </summary>
+        public double Time;
+
+        /// <summary>
+        /// SolveEoMオブジェクトの番号
+        /// </summary>
+        public Int32 Instance;
+
+        /// <summary>
+        /// 角度θ
+        /// </summary>
+        public float Theta;
+
+        /// <summary>
+        /// 速度v
+        /// </summary>
+        public float V;
+
+        /// <summary>
+        /// 運動エネルギー
+        /// </summary>
+        public float Kinetic_Energy;
+
+        /// <summary>
+        /// ポテンシャルエネルギー
+        /// </summary>
+        public float Potential_Energy;
+
+        #endregion フィールド
+    }
+
     /// <summary>
     /// C++で書かれたSolveEoMクラスをC#からアクセスするためのラッパークラス
     /// </summary>
@@ -16,6 +67,27 @@ namespace Solveeomcs
     {
         #region メソッド
 
+        /// <summary>
+        /// 動作中のシミュレーションサーバー（solveeomserver）の共有メモリに接続する
+        /// </summary>
+        /// <returns>接続できたかどうか（サーバーが動いていなければfalse）</returns>
+        [DllImport("solveeom", EntryPoint = "attachserver")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool AttachServer();
+
+        /// <summary>
+        /// シミュレーションサーバーの共有メモリから切断する
+        /// </summary>
+        [DllImport("solveeom", EntryPoint = "detachserver")]
+        public static extern void DetachServer();
+
+        /// <summary>
+        /// パラメータと状態のすべてを取り出す
+        /// </summary>
+        /// <param name="state">結果を格納する、要素数13の配列（l, r, m, μ, ρ, 空気抵抗の有無, 単振動にするかどうか, 駆動力の振幅, 角振動数, 初期位相, 経過時間, θ, dθ/dtの順、bool値は0か1）</param>
+        [DllImport("solveeom", EntryPoint = "getsnapshot")]
+        public static extern void GetSnapshot([Out] double[] state);
+
         /// <summary>
         /// 角度θの値に対するgetter
         /// </summary>
@@ -56,6 +128,31 @@ namespace Solveeomcs
         [DllImport("solveeom", EntryPoint = "nextstep")]
         public static extern float NextStep(float dt);
 
+        /// <summary>
+        /// 保存された軌跡(θ, dθ/dt)から、指定された物理量を一度の走査でまとめて求める
+        /// </summary>
+        /// <param name="theta">θの配列</param>
+        /// <param name="omega">dθ/dtの配列</param>
+        /// <param name="n">配列の要素数（0以下なら何もしない）</param>
+        /// <param name="observables">求める物理量のビットの論理和（1: 運動エネルギー, 2: ポテンシャルエネルギー, 4: 全エネルギー, 8: レイノルズ数, 16: 粘性抵抗, 32: 抗力係数, 64: 散逸する仕事率）</param>
+        /// <param name="result">結果を格納する、要素数n×(指定した物理量の数)の配列</param>
+        [DllImport("solveeom", EntryPoint = "observables")]
+        public static extern void Observables(double[] theta, double[] omega, Int32 n, Int32 observables, [Out] double[] result);
+
+        /// <summary>
+        /// Parareal法で、運動方程式を時刻tまで時間方向に並列に積分する（現在の状態は変更しない）
+        /// </summary>
+        /// <param name="t">指定時間</param>
+        /// <param name="nslices">スライスの数</param>
+        /// <param name="coarsedt">粗い解法（4次Runge-Kutta法）の時間刻み</param>
+        /// <param name="tol">反復の収束判定の許容誤差</param>
+        /// <param name="nthreads">スレッド数（0以下ならハードウェアのスレッド数）</param>
+        /// <param name="result">結果を格納する、要素数5の配列（θ, dθ/dt, 反復回数, 最後の修正量, 経過時間（秒）の順）</param>
+        /// <returns>積分に成功したかどうか（引数が正しくないか、積分に失敗したときはfalse）</returns>
+        [DllImport("solveeom", EntryPoint = "parareal")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool Parareal(double t, Int32 nslices, double coarsedt, double tol, Int32 nthreads, [Out] double[] result);
+
         /// <summary>
         /// ポテンシャルエネルギーを求める
         /// </summary>
@@ -63,6 +160,83 @@ namespace Solveeomcs
         [DllImport("solveeom", EntryPoint = "potential_energy")]
         public static extern float Potential_Energy();
 
+        /// <summary>
+        /// シミュレーションサーバーがこれまでに公開した状態の数を返す
+        /// </summary>
+        /// <returns>公開された状態の数（接続していなければ0）</returns>
+        [DllImport("solveeom", EntryPoint = "publishedsamples")]
+        public static extern UInt64 PublishedSamples();
+
+        /// <summary>
+        /// シミュレーションサーバーが公開した、指定されたSolveEoMオブジェクトの最新の状態を読み出す
+        /// </summary>
+        /// <param name="instance">SolveEoMオブジェクトの番号</param>
+        /// <param name="sample">読み出した状態</param>
+        /// <returns>読み出せたかどうか（接続していないか、リングバッファに残っていなければfalse）</returns>
+        [DllImport("solveeom", EntryPoint = "readlatest")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool ReadLatest(Int32 instance, out SharedSample sample);
+
+        /// <summary>
+        /// シミュレーションサーバーが公開した、通し番号indexの状態を読み出す
+        /// </summary>
+        /// <param name="index">通し番号</param>
+        /// <param name="sample">読み出した状態</param>
+        /// <returns>読み出せたかどうか（接続していないか、まだ公開されていないか、既に上書きされているか、書き込み中のままであればfalse）</returns>
+        [DllImport("solveeom", EntryPoint = "readsample")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool ReadSample(UInt64 index, out SharedSample sample);
+
+        /// <summary>
+        /// 記録された処理区間と、運動方程式の右辺で通った抵抗の分岐の回数を、Chrome/Perfettoで読めるトレース形式（JSON）で保存する（スレッドごとに最新の2^18個のみ）
+        /// </summary>
+        /// <param name="filename">保存ファイル名</param>
+        [DllImport("solveeom", EntryPoint = "savetrace")]
+        public static extern void SaveTrace(string filename);
+
+        /// <summary>
+        /// シミュレーションサーバーにコマンドを送る
+        /// </summary>
+        /// <param name="type">コマンドの種類（0: θ, 1: 速度, 2: 流体の種類, 3: 空気抵抗の有無, 4: 単振動にするかどうか, 5: サーバーの終了）</param>
+        /// <param name="instance">対象のSolveEoMオブジェクトの番号</param>
+        /// <param name="value">設定する値（bool値は0か1、流体の種類はSetFluidの引数）</param>
+        /// <returns>送れたかどうか（接続していないか、コマンドが正しくないか、キューが一杯ならfalse）</returns>
+        [DllImport("solveeom", EntryPoint = "sendcommand")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool SendCommand(Int32 type, Int32 instance, double value);
+
+        /// <summary>
+        /// θのパラメータ（θ0, v0, l, r, μ）に対する感度を、変分方程式を同時に積分して求める
+        /// </summary>
+        /// <param name="dt">時間刻み</param>
+        /// <param name="n">求める点の数</param>
+        /// <param name="result">結果を格納する、要素数6nの配列（各時刻について θ, ∂θ/∂θ0, ∂θ/∂v0, ∂θ/∂l, ∂θ/∂r, ∂θ/∂μ の順）</param>
+        [DllImport("solveeom", EntryPoint = "sensitivity")]
+        public static extern void Sensitivity(double dt, Int32 n, [Out] double[] result);
+
+        /// <summary>
+        /// シミュレーションサーバーのSolveEoMオブジェクトの数を返す
+        /// </summary>
+        /// <returns>SolveEoMオブジェクトの数（接続していなければ0）</returns>
+        [DllImport("solveeom", EntryPoint = "serverinstances")]
+        public static extern Int32 ServerInstances();
+
+        /// <summary>
+        /// 環境変数SOLVEEOM_RECORDによる自動記録を行うかどうかを設定する
+        /// </summary>
+        /// <param name="enable">自動記録を行うかどうか</param>
+        [DllImport("solveeom", EntryPoint = "setautorecording")]
+        public static extern void SetAutoRecording(bool enable);
+
+        /// <summary>
+        /// 周期的な駆動力 amplitude・cos(frequency・t + phase) を角加速度に加える
+        /// </summary>
+        /// <param name="amplitude">駆動力の振幅（角加速度, rad/s^2）</param>
+        /// <param name="frequency">駆動力の角振動数（rad/s）</param>
+        /// <param name="phase">駆動力の初期位相（rad）</param>
+        [DllImport("solveeom", EntryPoint = "setdrive")]
+        public static extern void SetDrive(double amplitude, double frequency, double phase);
+
         /// <summary>
         /// 流体の種類を切り替える
         /// </summary>
@@ -84,6 +258,13 @@ namespace Solveeomcs
         [DllImport("solveeom", EntryPoint = "setsimpleharmonic")]
         public static extern void SetSimpleharmonic(bool simpleharmonic);
 
+        /// <summary>
+        /// GetSnapshotで取り出したパラメータと状態を復元する
+        /// </summary>
+        /// <param name="state">パラメータと状態を格納した、要素数13の配列（GetSnapshotと同じ順）</param>
+        [DllImport("solveeom", EntryPoint = "setsnapshot")]
+        public static extern void SetSnapshot(double[] state);
+
         /// <summary>
         /// 角度θの値に対するsetter
         /// </summary>
@@ -98,6 +279,19 @@ namespace Solveeomcs
         [DllImport("solveeom", EntryPoint = "setv")]
         public static extern void SetV(float v);
 
+        /// <summary>
+        /// C APIの呼び出しの記録を開始する
+        /// </summary>
+        /// <param name="filename">記録ファイル名</param>
+        [DllImport("solveeom", EntryPoint = "startrecording")]
+        public static extern void StartRecording(string filename);
+
+        /// <summary>
+        /// C APIの呼び出しの記録を終了する
+        /// </summary>
+        [DllImport("solveeom", EntryPoint = "stoprecording")]
+        public static extern void StopRecording();
+
         #endregion メソッド
     }
 }
\ No newline at end of file
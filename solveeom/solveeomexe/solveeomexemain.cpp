@@ -5,6 +5,11 @@
     This software is released under the BSD 2-Clause License.
 */
 #include "../solveeom/solveeommain.h"
+#include <algorithm>                // for std::max
+#include <cmath>                    // for std::fabs, std::sqrt
+#include <iostream>                 // for std::cout
+#include <thread>                   // for std::thread
+#include <boost/format.hpp>         // for boost::format
 
 int main()
 {
@@ -44,5 +49,53 @@ int main()
     init(1.0f, 0.05f, true, false, 3.1241394f);
     saveresult(0.001, "air_resistance_yes_179.csv", 30.0);
 
+    init(1.0f, 0.05f, true, false, 3.1241394f);
+    saveresult_decimated(0.001, "air_resistance_yes_179_decimated.csv", 30.0, 1.0E-6, 1);
+
+    // 空気抵抗ありの軌跡に、ずらした初期値からパラメータをフィッティングする（球の半径と密度は測定値とする）
+    init(1.0f, 0.05f, true, false, 3.1241394f);
+    saveresult(0.01, "fit_data.csv", 10.0);
+
+    double const initials[] = {
+        1.02, 3.0E-5, 1.0,
+        0.98, 1.0E-5, 1.5,
+        1.01, 2.0E-5, 0.8,
+        0.99, 1.5E-5, 1.2
+    };
+    double result[6];
+    if (fitparameters("fit_data.csv", true, false, 0.0, 0.05f, 2698.9, initials, 4, 0, result)) {
+        std::cout << boost::format("l = %.6f, myu = %.6e, rho = %.6f\n") % result[0] % result[1] % result[2];
+        std::cout << boost::format("residual = %.6e, condition = %.3e, elapsed = %.3f s\n") % result[3] % result[4] % result[5];
+    }
+
+    // 空気抵抗ありの駆動振り子について、分岐図のためのポアンカレ断面を求める
+    init(1.0f, 0.05f, true, false, 0.2f);
+    setdrive(0.0, 2.0 / 3.0 * std::sqrt(9.80665), 0.0);
+
+    double const amplitudes[] = { 0.90 * 9.80665, 0.95 * 9.80665, 1.00 * 9.80665, 1.05 * 9.80665 };
+    double elapsed;
+    if (poincaresection(amplitudes, 4, 100, 200, "poincare_section.bin", 0, &elapsed)) {
+        std::cout << boost::format("poincare section: elapsed = %.3f s\n") % elapsed;
+    }
+
+    // 空気抵抗ありの軌跡をParareal法で積分し、逐次の積分に対する速度向上をスレッド数ごとに求める
+    init(1.0f, 0.05f, true, false, 3.1241394f);
+
+    double serial[5];
+    if (!parareal(200.0, 1, 0.01, 1.0E-10, 1, serial)) {
+        return 0;
+    }
+
+    auto const ncores = static_cast<std::int32_t>(std::max(std::thread::hardware_concurrency(), 1U));
+    for (auto nthreads = 1; nthreads <= ncores; nthreads *= 2) {
+        double parallel[5];
+        if (!parareal(200.0, nthreads, 0.01, 1.0E-10, nthreads, parallel)) {
+            break;
+        }
+
+        std::cout << boost::format("parareal: threads = %d, iterations = %d, error = %.3e, speedup = %.2f\n")
+            % nthreads % parallel[2] % std::max(std::fabs(parallel[0] - serial[0]), std::fabs(parallel[1] - serial[1])) % (serial[4] / parallel[4]);
+    }
+
     return 0;
 }
@@ -0,0 +1,254 @@
+﻿/*! \file replayer.cpp
+    \brief 記録されたC APIの呼び出しを再生するクラスの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "replayer.h"
+#include "../solveeom/solveeommain.h"
+#include <algorithm>                // for std::equal
+#include <chrono>                   // for std::chrono
+#include <cstring>                  // for std::memcpy, std::memcmp
+#include <fstream>                  // for std::ifstream
+#include <iterator>                 // for std::istreambuf_iterator
+#include <stdexcept>                // for std::runtime_error
+#include <type_traits>              // for std::is_void_v, std::invoke_result_t
+#include <boost/format.hpp>         // for boost::format
+
+namespace solveeomreplay {
+    // #region コンストラクタ・デストラクタ
+
+    Replayer::Replayer(std::string const & filename) :
+        pos_(solveeom::CALLRECORDMAGIC.size())
+    {
+        std::ifstream ifs(filename, std::ios::binary);
+        if (!ifs) {
+            throw std::runtime_error(filename + "が開けませんでした");
+        }
+
+        data_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+        if (data_.size() < solveeom::CALLRECORDMAGIC.size() ||
+            !std::equal(solveeom::CALLRECORDMAGIC.begin(), solveeom::CALLRECORDMAGIC.end(), data_.begin())) {
+            throw std::runtime_error(filename + "は記録ファイルではありません");
+        }
+
+        // initより前の呼び出しは再生できない
+        if (data_.size() == pos_ || static_cast<solveeom::Call_type>(data_[pos_]) != solveeom::Call_type::INIT) {
+            throw std::runtime_error(filename + "はinitの呼び出しから始まっていません");
+        }
+
+        // 環境変数SOLVEEOM_RECORDが記録ファイルを指していると、再生中のinitで上書きされてしまう
+        setautorecording(false);
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    bool Replayer::operator()()
+    {
+        using solveeom::Call_type;
+
+        while (pos_ < data_.size()) {
+            auto const type = static_cast<Call_type>(read<std::uint8_t>());
+
+            switch (type) {
+            case Call_type::INIT:
+            {
+                auto const l = read<float>();
+                auto const r = read<float>();
+                auto const resistance = read<bool>();
+                auto const simpleharmonic = read<bool>();
+                auto const theta0 = read<float>();
+                call(type, [=] { init(l, r, resistance, simpleharmonic, theta0); });
+            }
+            break;
+
+            case Call_type::NEXTSTEP:
+            {
+                auto const dt = read<float>();
+                call(type, [=] { return nextstep(dt); });
+            }
+            break;
+
+            case Call_type::GETTHETA:
+                call(type, [] { return gettheta(); });
+                break;
+
+            case Call_type::GETV:
+                call(type, [] { return getv(); });
+                break;
+
+            case Call_type::KINETICENERGY:
+                call(type, [] { return kinetic_energy(); });
+                break;
+
+            case Call_type::POTENTIALENERGY:
+                call(type, [] { return potential_energy(); });
+                break;
+
+            case Call_type::SETFLUID:
+            {
+                auto const fluid = read<std::int32_t>();
+                call(type, [=] { setfluid(fluid); });
+            }
+            break;
+
+            case Call_type::SETRESISTANCE:
+            {
+                auto const resistance = read<bool>();
+                call(type, [=] { setresistance(resistance); });
+            }
+            break;
+
+            case Call_type::SETSIMPLEHARMONIC:
+            {
+                auto const simpleharmonic = read<bool>();
+                call(type, [=] { setsimpleharmonic(simpleharmonic); });
+            }
+            break;
+
+            case Call_type::SETTHETA:
+            {
+                auto const theta = read<float>();
+                call(type, [=] { settheta(theta); });
+            }
+            break;
+
+            case Call_type::SETV:
+            {
+                auto const v = read<float>();
+                call(type, [=] { setv(v); });
+            }
+            break;
+
+            case Call_type::SETDRIVE:
+            {
+                auto const amplitude = read<double>();
+                auto const frequency = read<double>();
+                auto const phase = read<double>();
+                call(type, [=] { setdrive(amplitude, frequency, phase); });
+            }
+            break;
+
+            case Call_type::SETSNAPSHOT:
+            {
+                auto const state = read<std::array<double, 13>>();
+                call(type, [=] { setsnapshot(state.data()); });
+            }
+            break;
+
+            default:
+                throw std::runtime_error("記録ファイルが壊れています");
+            }
+        }
+
+        for (auto const & s : statistics_) {
+            if (s.mismatch) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Replayer::report(std::ostream & os) const
+    {
+        static char const * const names[Replayer::NCALLTYPES] = {
+            "init", "nextstep", "gettheta", "getv", "kinetic_energy", "potential_energy",
+            "setfluid", "setresistance", "setsimpleharmonic", "settheta", "setv", "setdrive", "setsnapshot"
+        };
+
+        for (auto i = 0; i < Replayer::NCALLTYPES; i++) {
+            auto const & s = statistics_[i];
+            if (!s.count) {
+                continue;
+            }
+
+            // ヒストグラムから中央値と99パーセンタイルの上限を求める
+            auto const percentile = [&s](double p)
+            {
+                std::uint64_t sum = 0;
+                for (auto k = 0; k < Replayer::NBINS; k++) {
+                    sum += s.histogram[k];
+                    if (sum >= p * s.count) {
+                        return std::int64_t(1) << (k + 1);
+                    }
+                }
+
+                return s.max;
+            };
+
+            os << boost::format("%s: calls = %d, mean = %.1f ns, p50 < %d ns, p99 < %d ns, max = %d ns, mismatches = %d\n")
+                % names[i] % s.count % (static_cast<double>(s.total) / s.count) % percentile(0.5) % percentile(0.99) % s.max % s.mismatch;
+
+            for (auto k = 0; k < Replayer::NBINS; k++) {
+                if (s.histogram[k]) {
+                    os << boost::format("    [%d, %d) ns: %d\n") % (std::int64_t(1) << k) % (std::int64_t(1) << (k + 1)) % s.histogram[k];
+                }
+            }
+        }
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    template <typename F>
+    void Replayer::call(solveeom::Call_type type, F && func)
+    {
+        using result_type = std::invoke_result_t<F>;
+
+        auto & s = statistics_[static_cast<std::size_t>(type)];
+        std::int64_t ns;
+
+        if constexpr (std::is_void_v<result_type>) {
+            auto const begin = std::chrono::steady_clock::now();
+            func();
+            ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        }
+        else {
+            auto const begin = std::chrono::steady_clock::now();
+            auto const result = func();
+            ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+            // ビット単位で比較する
+            auto const recorded = read<result_type>();
+            if (std::memcmp(&result, &recorded, sizeof(result_type))) {
+                s.mismatch++;
+            }
+        }
+
+        auto bin = 0;
+        while (bin < Replayer::NBINS - 1 && (std::int64_t(1) << (bin + 1)) <= ns) {
+            bin++;
+        }
+
+        s.count++;
+        s.histogram[bin]++;
+        s.max = std::max(s.max, ns);
+        s.total += ns;
+    }
+
+    template <typename T>
+    T Replayer::read()
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            return read<std::uint8_t>() != 0;
+        }
+        else {
+            if (pos_ + sizeof(T) > data_.size()) {
+                throw std::runtime_error("記録ファイルが途中で終わっています");
+            }
+
+            T value;
+            std::memcpy(&value, data_.data() + pos_, sizeof(T));
+            pos_ += sizeof(T);
+
+            return value;
+        }
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,181 @@
+﻿/*! \file replayer.h
+    \brief 記録されたC APIの呼び出しを再生するクラスの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _REPLAYER_H_
+#define _REPLAYER_H_
+
+#include "../solveeom/callrecorder.h"
+#include <array>                // for std::array
+#include <cstddef>              // for std::size_t
+#include <cstdint>              // for std::int64_t, std::uint64_t
+#include <ostream>              // for std::ostream
+#include <string>               // for std::string
+#include <vector>               // for std::vector
+
+namespace solveeomreplay {
+    //! A class.
+    /*!
+        記録されたC APIの呼び出しを、できるだけ速く再生するクラス
+        戻り値がビット単位で記録と一致するかを確認し、関数ごとの所要時間のヒストグラムを集計する
+    */
+    class Replayer final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            記録ファイルでないか、initの呼び出しから始まっていなければstd::runtime_errorを投げる
+            再生中は環境変数SOLVEEOM_RECORDによる自動記録を無効にする
+            \param filename 記録ファイル名
+        */
+        explicit Replayer(std::string const & filename);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Replayer() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            記録を最後まで再生する
+            \return すべての戻り値が記録と一致したかどうか
+        */
+        bool operator()();
+
+        //! A public member function (const).
+        /*!
+            再生結果を出力する
+            \param os 出力先のストリーム
+        */
+        void report(std::ostream & os) const;
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function (template function).
+        /*!
+            関数を呼び出して所要時間を集計し、戻り値を記録と比較する
+            \param type 呼び出す関数
+            \param func 呼び出す関数オブジェクト
+        */
+        template <typename F>
+        void call(solveeom::Call_type type, F && func);
+
+        //! A private member function (template function).
+        /*!
+            記録から値を一つ読み出す
+            \return 読み出した値
+        */
+        template <typename T>
+        T read();
+
+        // #endregion privateメンバ関数
+
+        // #region メンバ変数
+
+        //! A private static member variable (constant expression).
+        /*!
+            ヒストグラムのビンの数（ビンkは[2^k, 2^(k+1))ナノ秒）
+        */
+        static auto constexpr NBINS = 40;
+
+        //! A private static member variable (constant expression).
+        /*!
+            記録される関数の種類の数
+        */
+        static auto constexpr NCALLTYPES = 13;
+
+        //! A struct.
+        /*!
+            一つの関数の所要時間の統計
+        */
+        struct Statistics final {
+            //! A public member variable.
+            /*!
+                呼び出し回数
+            */
+            std::uint64_t count = 0;
+
+            //! A public member variable.
+            /*!
+                所要時間のヒストグラム
+            */
+            std::array<std::uint64_t, Replayer::NBINS> histogram = {};
+
+            //! A public member variable.
+            /*!
+                最大の所要時間（ナノ秒）
+            */
+            std::int64_t max = 0;
+
+            //! A public member variable.
+            /*!
+                記録と戻り値が一致しなかった回数
+            */
+            std::uint64_t mismatch = 0;
+
+            //! A public member variable.
+            /*!
+                所要時間の合計（ナノ秒）
+            */
+            std::int64_t total = 0;
+        };
+
+        //! A private member variable.
+        /*!
+            記録ファイルの内容
+        */
+        std::vector<char> data_;
+
+        //! A private member variable.
+        /*!
+            記録ファイルの読み出し位置
+        */
+        std::size_t pos_;
+
+        //! A private member variable.
+        /*!
+            関数ごとの統計
+        */
+        std::array<Statistics, Replayer::NCALLTYPES> statistics_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        Replayer() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Replayer(Replayer const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Replayer & operator=(Replayer const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _REPLAYER_H_
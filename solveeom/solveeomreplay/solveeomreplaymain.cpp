@@ -0,0 +1,35 @@
+﻿/*! \file solveeomreplaymain.cpp
+    \brief 記録されたC APIの呼び出しを再生するツールのメイン関数
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "replayer.h"
+#include <cstdlib>                  // for EXIT_FAILURE, EXIT_SUCCESS
+#include <iostream>                 // for std::cerr, std::cout
+#include <stdexcept>                // for std::runtime_error
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2) {
+        std::cerr << "使い方: solveeomreplay 記録ファイル名" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        solveeomreplay::Replayer replayer(argv[1]);
+        auto const exact = replayer();
+        replayer.report(std::cout);
+
+        if (!exact) {
+            std::cout << "記録と一致しない戻り値がありました" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (std::runtime_error const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
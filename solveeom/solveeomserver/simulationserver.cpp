@@ -0,0 +1,115 @@
+﻿/*! \file simulationserver.cpp
+    \brief SolveEoMオブジェクトを保持し、その状態を共有メモリに公開するサーバーの実装
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "simulationserver.h"
+#include <chrono>                           // for std::chrono
+#include <thread>                           // for std::this_thread::sleep_until
+
+namespace solveeomserver {
+    // #region コンストラクタ・デストラクタ
+
+    SimulationServer::SimulationServer(std::int32_t ninstances, double dt, float theta0) :
+        dt_(dt)
+    {
+        // 動いているサーバーの共有メモリは消さない
+        if (solveeom::SharedMemory::running()) {
+            throw boost::interprocess::interprocess_exception("別のサーバーが既に動いています");
+        }
+
+        // 前回異常終了したときの残骸を消しておく
+        solveeom::SharedMemory::remove();
+
+        shared_ = std::make_unique<solveeom::SharedMemory>(boost::interprocess::create_only, ninstances);
+
+        for (auto i = 0; i < ninstances; i++) {
+            solvers_.push_back(std::make_unique<solveeom::SolveEoM>(1.0f, 0.05f, false, false, theta0));
+        }
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    void SimulationServer::operator()()
+    {
+        auto next = std::chrono::steady_clock::now();
+        auto const period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dt_));
+
+        while (dispatch()) {
+            time_ += dt_;
+
+            for (auto i = 0U; i < solvers_.size(); i++) {
+                auto & se = *solvers_[i];
+                se(static_cast<float>(dt_));
+
+                solveeom::SharedSample sample;
+                sample.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                sample.time = time_;
+                sample.instance = static_cast<std::int32_t>(i);
+                sample.theta = se.Theta;
+                sample.v = se.V;
+                sample.kinetic_energy = se.kinetic_energy();
+                sample.potential_energy = se.potential_energy();
+
+                (*shared_)->ring.write(sample);
+            }
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    bool SimulationServer::dispatch()
+    {
+        solveeom::Command command;
+
+        while ((*shared_)->commands.pop(command)) {
+            if (!command.valid(static_cast<std::int32_t>(solvers_.size()))) {
+                continue;
+            }
+
+            if (command.type == solveeom::Command_type::QUIT) {
+                return false;
+            }
+
+            auto & se = *solvers_[command.instance];
+            switch (command.type) {
+            case solveeom::Command_type::SETTHETA:
+                se.Theta(static_cast<float>(command.value));
+                break;
+
+            case solveeom::Command_type::SETV:
+                se.V(static_cast<float>(command.value));
+                break;
+
+            case solveeom::Command_type::SETFLUID:
+                se.setfluid(static_cast<std::int32_t>(command.value));
+                break;
+
+            case solveeom::Command_type::SETRESISTANCE:
+                se.Resistance(command.value != 0.0);
+                break;
+
+            case solveeom::Command_type::SETSIMPLEHARMONIC:
+                se.Simpleharmonic(command.value != 0.0);
+                break;
+
+            default:
+                // valid()で弾かれているので来ない
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,122 @@
+﻿/*! \file simulationserver.h
+    \brief SolveEoMオブジェクトを保持し、その状態を共有メモリに公開するサーバーの宣言
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#ifndef _SIMULATIONSERVER_H_
+#define _SIMULATIONSERVER_H_
+
+#include "../solveeom/sharedmemory.h"
+#include "../solveeom/solveeom.h"
+#include <cstdint>                                          // for std::int32_t
+#include <memory>                                           // for std::unique_ptr
+#include <vector>                                           // for std::vector
+
+namespace solveeomserver {
+    //! A class.
+    /*!
+        SolveEoMオブジェクトを保持して一定の時間刻みで積分し、その状態を共有メモリのリングバッファに公開するサーバー
+        コマンドも同じ共有メモリ上のキューで受け付けるので、任意の数のプロセスが積分を重複させずに状態を読み出せる
+        クライアントはsolveeom.dllのattachserverなどの関数から接続する
+    */
+    class SimulationServer final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            別のサーバーが既に動いていればboost::interprocess::interprocess_exceptionを投げる
+            \param ninstances SolveEoMオブジェクトの数
+            \param dt 時間刻み（秒）
+            \param theta0 θの初期値
+        */
+        SimulationServer(std::int32_t ninstances, double dt, float theta0);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ（共有メモリはSharedMemoryのデストラクタで削除される）
+        */
+        ~SimulationServer() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            QUITコマンドを受け取るまで、実時間に合わせて積分と公開を繰り返す
+        */
+        void operator()();
+
+        // #endregion publicメンバ関数
+
+    private:
+        // #region privateメンバ関数
+
+        //! A private member function.
+        /*!
+            溜まっているコマンドをすべて処理する
+            他のプロセスから送られるので、正しくないコマンドは無視する
+            \return QUITコマンドを受け取ったらfalse
+        */
+        bool dispatch();
+
+        // #endregion privateメンバ関数
+
+        // #region メンバ変数
+
+        //! A private member variable.
+        /*!
+            時間刻み（秒）
+        */
+        double dt_;
+
+        //! A private member variable.
+        /*!
+            状態を公開し、コマンドを受け付ける共有メモリ
+        */
+        std::unique_ptr<solveeom::SharedMemory> shared_;
+
+        //! A private member variable.
+        /*!
+            SolveEoMオブジェクトの配列
+        */
+        std::vector<std::unique_ptr<solveeom::SolveEoM>> solvers_;
+
+        //! A private member variable.
+        /*!
+            シミュレーション内の時刻
+        */
+        double time_ = 0.0;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        SimulationServer() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        SimulationServer(SimulationServer const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        SimulationServer & operator=(SimulationServer const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif  // _SIMULATIONSERVER_H_
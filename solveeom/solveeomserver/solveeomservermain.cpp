@@ -0,0 +1,48 @@
+﻿/*! \file solveeomservermain.cpp
+    \brief シミュレーションサーバーのメイン関数
+
+    Copyright © 2016-2018 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+#include "simulationserver.h"
+#include <cmath>                    // for std::isfinite
+#include <cstdint>                  // for std::int32_t
+#include <cstdlib>                  // for EXIT_FAILURE, EXIT_SUCCESS
+#include <iostream>                 // for std::cerr
+#include <stdexcept>                // for std::logic_error
+#include <string>                   // for std::stod, std::stof, std::stoi
+#include <boost/interprocess/exceptions.hpp>    // for boost::interprocess::interprocess_exception
+
+int main(int argc, char * argv[])
+{
+    std::int32_t ninstances = 1;
+    auto dt = 0.01;
+    auto theta0 = 0.5235988f;
+
+    try {
+        ninstances = argc > 1 ? std::stoi(argv[1]) : ninstances;
+        dt = argc > 2 ? std::stod(argv[2]) : dt;
+        theta0 = argc > 3 ? std::stof(argv[3]) : theta0;
+    }
+    catch (std::logic_error const &) {
+        // 数値でないか範囲外（std::invalid_argumentかstd::out_of_range）なら、下で使い方を表示する
+        ninstances = 0;
+    }
+
+    // dtが0以下だと実時間に合わせる待ちがなくなり、空回りする
+    if (argc > 4 || ninstances <= 0 || !(dt > 0.0) || !std::isfinite(dt) || !std::isfinite(theta0)) {
+        std::cerr << "使い方: solveeomserver [SolveEoMオブジェクトの数（1以上）] [時間刻み（秒、正の数）] [θの初期値]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        solveeomserver::SimulationServer server(ninstances, dt, theta0);
+        server();
+    }
+    catch (boost::interprocess::interprocess_exception const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}